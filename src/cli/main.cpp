@@ -5,6 +5,7 @@
 #include "core/glimpse.h"
 #include "core/logger.h"
 #include "core/render.h"
+#include "core/scaling.h"
 
 using namespace glimpse;
 
@@ -21,9 +22,24 @@ int main(int argc, char **argv) {
   logger.log("Samples: ", options.samples);
   logger.log("Max Depth: ", options.max_depth);
   logger.log("Scene: ", options.scene);
+  logger.log("Time Budget: ", options.time_budget);
+  logger.log("Error Target: ", options.error_target);
+  logger.log("Pixel Order: ", to_string(options.pixel_order));
+  logger.log("Regions: ", options.regions.size());
+  logger.log("Seed: ", options.seed);
+  logger.log("Threads: ", options.threads, options.pin_threads ? " (pinned)" : "");
+  logger.log("Roulette Depth: ", options.roulette_depth);
+  logger.log("Direct Lighting: ", options.next_event ? "next-event estimation, " : "light/BSDF mixture",
+             options.next_event ? to_string(options.mis) : "");
+  logger.log("Engine: ", to_string(options.engine), options.sort_by_material ? " (material sorted)" : "",
+             options.sort_rays ? " (ray sorted)" : "", options.packets ? " (camera ray packets)" : "");
+
+  // Seed before building the scene, so seeded runs also get the same scene
+  Random::set_seed(options.seed);
 
   // Scene
   auto scene = Scene::SceneMap[Scene::SceneNames[options.scene]]();
+  scene.cam.initialize();
 
   // Image
   auto aspect_ratio = scene.cam.aspect_ratio;
@@ -41,9 +57,46 @@ int main(int argc, char **argv) {
   auto empty_material = shared_ptr<material>();
   // quad lights;
   scene.lights.add(make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), empty_material));
+  logger.log("Scene Features: ", to_string(SceneFeatures::of(scene)), options.specialize ? "" : " (generic variant)");
 
   Renderer renderer;
+  renderer.settings.time_budget = options.time_budget;
+  renderer.settings.error_target = options.error_target;
+  renderer.settings.pixel_order = options.pixel_order;
+  renderer.settings.regions = options.regions;
+  if (!options.importance.empty()) {
+    Image weights;
+    if (weights.read(options.importance)) {
+      renderer.settings.importance = importance_from_image(weights);
+    } else {
+      logger.log("Failed to read importance map ", options.importance);
+    }
+  }
+  renderer.settings.num_threads = options.threads;
+  renderer.settings.pin_threads = options.pin_threads;
+  renderer.settings.roulette.enabled = options.roulette_depth >= 0;
+  renderer.settings.roulette.start_depth = options.roulette_depth;
+  renderer.settings.direct_lighting.next_event_estimation = options.next_event;
+  renderer.settings.direct_lighting.heuristic = options.mis;
+  renderer.settings.engine = options.engine;
+  renderer.settings.sort_by_material = options.sort_by_material;
+  renderer.settings.sort_rays = options.sort_rays;
+  renderer.settings.packet_camera_rays = options.packets;
+  renderer.settings.specialize = options.specialize;
+
+  if (auto modes = sampling_modes(renderer.settings, scene.cam.uncapped_spp); modes.size() > 1) {
+    logger.log("Conflicting sampling modes: ", modes[0], " and ", modes[1], ", pick one");
+    return 1;
+  }
+
+  if (options.scaling > 0) {
+    logger.log("Scaling run up to ", options.scaling, " threads");
+    print_scaling_report(run_scaling(scene, options.scaling, renderer.settings), std::cout);
+    return 0;
+  }
+
   renderer.render_scene(scene, image, nullptr);
+  if (options.worker_stats) renderer.print_worker_stats(std::cout);
 
   auto endTime = std::chrono::high_resolution_clock::now();
   auto duration = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count();
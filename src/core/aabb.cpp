@@ -1,14 +1,17 @@
 #include "aabb.h"
 
-using namespace glimpse;
+#include <algorithm>
 
-bool aabb::hit(const ray& r, interval ray_t) const {
-  const point3& ray_orig = r.origin();
-  const vec3& ray_dir = r.direction();
+namespace glimpse {
+
+template <typename T>
+bool basic_aabb<T>::hit(const basic_ray<T>& r, basic_interval<T> ray_t) const {
+  const basic_vec3<T>& ray_orig = r.origin();
+  const basic_vec3<T>& ray_dir = r.direction();
 
   for (int axis = 0; axis < 3; axis++) {
-    const interval& ax = axis_interval(axis);
-    const double adinv = 1.0 / ray_dir[axis];
+    const basic_interval<T>& ax = axis_interval(axis);
+    const T adinv = 1 / ray_dir[axis];
 
     auto t0 = (ax.min - ray_orig[axis]) * adinv;
     auto t1 = (ax.max - ray_orig[axis]) * adinv;
@@ -24,4 +27,36 @@ bool aabb::hit(const ray& r, interval ray_t) const {
     if (ray_t.max <= ray_t.min) return false;
   }
   return true;
-}
\ No newline at end of file
+}
+
+template <typename T>
+int basic_aabb<T>::hit_packet(const RayPacket& packet, int active, real t_min, const real t_max[]) const {
+  // Same slab test as above, without branches so every lane runs the same instructions. In the packet's precision.
+  real t_near[RayPacket::width], t_far[RayPacket::width];
+  for (int lane = 0; lane < RayPacket::width; lane++) {
+    t_near[lane] = t_min;
+    t_far[lane] = t_max[lane];
+  }
+
+  auto slab = [&](const basic_interval<T>& ax, const real* orig, const real* adinv) {
+    const real min = static_cast<real>(ax.min), max = static_cast<real>(ax.max);
+    for (int lane = 0; lane < RayPacket::width; lane++) {
+      real t0 = (min - orig[lane]) * adinv[lane];
+      real t1 = (max - orig[lane]) * adinv[lane];
+      t_near[lane] = std::max(t_near[lane], std::min(t0, t1));
+      t_far[lane] = std::min(t_far[lane], std::max(t0, t1));
+    }
+  };
+  slab(x, packet.origin_x, packet.inv_direction_x);
+  slab(y, packet.origin_y, packet.inv_direction_y);
+  slab(z, packet.origin_z, packet.inv_direction_z);
+
+  int hits = 0;
+  for (int lane = 0; lane < RayPacket::width; lane++) hits |= (t_near[lane] < t_far[lane] ? 1 : 0) << lane;
+  return hits & active;
+}
+
+template class basic_aabb<float>;
+template class basic_aabb<double>;
+
+}  // namespace glimpse
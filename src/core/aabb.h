@@ -2,40 +2,47 @@
 
 #include "interval.h"
 #include "ray.h"
+#include "ray_packet.h"
 
 namespace glimpse {
-class aabb {
+template <typename T>
+class basic_aabb {
  public:
-  interval x, y, z;
+  basic_interval<T> x, y, z;
 
-  aabb() {}  // The default AABB is empty, since intervals are empty by default.
+  basic_aabb() {}  // The default AABB is empty, since intervals are empty by default.
 
-  aabb(const interval& x, const interval& y, const interval& z) : x(x), y(y), z(z) { pad_to_minimums(); }
+  basic_aabb(const basic_interval<T>& x, const basic_interval<T>& y, const basic_interval<T>& z) : x(x), y(y), z(z) {
+    pad_to_minimums();
+  }
 
-  aabb(const point3& a, const point3& b) {
+  basic_aabb(const basic_vec3<T>& a, const basic_vec3<T>& b) {
     // Treat the two points a and b as extrema for the bounding box, so we don't require a
     // particular minimum/maximum coordinate order.
 
-    x = (a[0] <= b[0]) ? interval(a[0], b[0]) : interval(b[0], a[0]);
-    y = (a[1] <= b[1]) ? interval(a[1], b[1]) : interval(b[1], a[1]);
-    z = (a[2] <= b[2]) ? interval(a[2], b[2]) : interval(b[2], a[2]);
+    x = (a[0] <= b[0]) ? basic_interval<T>(a[0], b[0]) : basic_interval<T>(b[0], a[0]);
+    y = (a[1] <= b[1]) ? basic_interval<T>(a[1], b[1]) : basic_interval<T>(b[1], a[1]);
+    z = (a[2] <= b[2]) ? basic_interval<T>(a[2], b[2]) : basic_interval<T>(b[2], a[2]);
 
     pad_to_minimums();
   }
 
-  aabb(const aabb& box0, const aabb& box1) {
-    x = interval(box0.x, box1.x);
-    y = interval(box0.y, box1.y);
-    z = interval(box0.z, box1.z);
+  basic_aabb(const basic_aabb& box0, const basic_aabb& box1) {
+    x = basic_interval<T>(box0.x, box1.x);
+    y = basic_interval<T>(box0.y, box1.y);
+    z = basic_interval<T>(box0.z, box1.z);
   }
 
-  const interval& axis_interval(int n) const {
+  const basic_interval<T>& axis_interval(int n) const {
     if (n == 1) return y;
     if (n == 2) return z;
     return x;
   }
 
-  bool hit(const ray& r, interval ray_t) const;
+  bool hit(const basic_ray<T>& r, basic_interval<T> ray_t) const;
+
+  // Slab test of the `active` lanes of a packet, lane i over (t_min, t_max[i]). Returns the lanes that hit.
+  int hit_packet(const RayPacket& packet, int active, real t_min, const real t_max[]) const;
 
   int longest_axis() const {
     // Returns the index of the longest axis of the bounding box.
@@ -46,23 +53,40 @@ class aabb {
       return y.size() > z.size() ? 1 : 2;
   }
 
-  static const aabb empty, universe;
+  static const basic_aabb empty, universe;
 
  private:
   void pad_to_minimums() {
     // Adjust the AABB so that no side is narrower than some delta, padding if necessary.
 
-    double delta = 0.0001;
+    T delta = T(0.0001);
     if (x.size() < delta) x = x.expand(delta);
     if (y.size() < delta) y = y.expand(delta);
     if (z.size() < delta) z = z.expand(delta);
   }
 };
 
-inline aabb operator+(const aabb& bbox, const vec3& offset) {
-  return aabb(bbox.x + offset.x(), bbox.y + offset.y(), bbox.z + offset.z());
+template <typename T>
+const basic_aabb<T> basic_aabb<T>::empty(basic_interval<T>::empty, basic_interval<T>::empty,
+                                         basic_interval<T>::empty);
+template <typename T>
+const basic_aabb<T> basic_aabb<T>::universe(basic_interval<T>::universe, basic_interval<T>::universe,
+                                            basic_interval<T>::universe);
+
+template <typename T>
+inline basic_aabb<T> operator+(const basic_aabb<T>& bbox, const basic_vec3<T>& offset) {
+  return basic_aabb<T>(bbox.x + offset.x(), bbox.y + offset.y(), bbox.z + offset.z());
 }
 
-inline aabb operator+(const vec3& offset, const aabb& bbox) { return bbox + offset; }
+template <typename T>
+inline basic_aabb<T> operator+(const basic_vec3<T>& offset, const basic_aabb<T>& bbox) {
+  return bbox + offset;
+}
+
+using aabb = basic_aabb<real>;
+
+// Both precisions are compiled in aabb.cpp
+extern template class basic_aabb<float>;
+extern template class basic_aabb<double>;
 
-}  // namespace glimpse
\ No newline at end of file
+}  // namespace glimpse
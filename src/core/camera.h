@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include "ray.h"
 
 namespace glimpse {
@@ -53,17 +55,27 @@ class camera {
   }
 
   // normalised coordinates!
+  ray get_ray(double s, double t) const { return get_ray<true, true>(s, t); }
+
+  // Same parameters, and so the same rays
+  bool operator==(const camera &) const = default;
+
+  // get_ray() with what the scene is known not to need compiled out, see SceneFeatures: with `Defocus` false the
+  // lens is never sampled, with `Motion` false every ray starts at time 0 instead of drawing a random time.
+  template <bool Defocus, bool Motion>
   ray get_ray(double s, double t) const {
     // without defocus blur, all rays pass through the origin
 
-    auto ray_origin = (defocus_angle <= 0) ? origin : defocus_disk_sample();
+    auto ray_origin = (Defocus && defocus_angle > 0) ? defocus_disk_sample() : origin;
 
     auto ray_direction = lower_left_corner + s * horizontal + t * vertical - ray_origin;
 
     // Random time for motion blur?
-    return ray(ray_origin, ray_direction, random_double());
+    return ray(ray_origin, ray_direction, Motion ? random_double() : 0.0);
   }
 
+  bool has_defocus() const { return defocus_angle > 0; }
+
   point3 defocus_disk_sample() const {
     // Returns a random point in the camera defocus disk.
     auto p = random_in_unit_disk();
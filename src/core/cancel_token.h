@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace glimpse {
+
+// Cancellation handle for one render. Copies share the same state, so the caller keeps one copy and hands
+// another to Renderer::render(). A default constructed token is fresh (not cancelled), give each render its own.
+class CancelToken {
+ public:
+  CancelToken() : m_State(std::make_shared<State>()) {}
+
+  // Ask the render to stop. Safe to call from any thread, any number of times.
+  void cancel() {
+    // The time goes in first, so whoever sees the flag also sees when it was raised.
+    std::chrono::steady_clock::rep unset = 0;
+    m_State->cancel_time.compare_exchange_strong(unset, std::chrono::steady_clock::now().time_since_epoch().count());
+    m_State->cancelled.store(true);
+  }
+
+  bool is_cancelled() const { return m_State->cancelled.load(std::memory_order_relaxed); }
+
+  // When cancel() was first called, to measure how long the render took to stop.
+  std::chrono::steady_clock::time_point cancel_time() const {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_State->cancel_time.load()));
+  }
+
+ private:
+  struct State {
+    std::atomic<bool> cancelled{false};
+    std::atomic<std::chrono::steady_clock::rep> cancel_time{0};
+  };
+
+  std::shared_ptr<State> m_State;
+};
+
+}  // namespace glimpse
@@ -1,8 +1,14 @@
 #pragma once
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "pixel_order.h"
+#include "render.h"
+#include "tile_scheduler.h"
+
 namespace glimpse {
 
 struct CmdOptions {
@@ -11,6 +17,24 @@ struct CmdOptions {
   int samples = 100;
   int max_depth = 50;
   int scene = 1;
+  double time_budget = 0;   // seconds, 0 renders the camera's samples per pixel
+  double error_target = 0;  // mean relative error of the frame, 0 renders the camera's samples per pixel
+  PixelOrder pixel_order = PixelOrder::Scanline;
+  std::vector<Tile> regions;  // pixel rectangles to render, empty renders the whole frame
+  uint32_t seed = 0;          // 0 draws a random seed
+  std::string importance;     // weight image spreading the sample budget, see RenderSettings::importance
+  int threads = 0;            // render workers, 0 uses every hardware thread
+  bool pin_threads = false;   // bind each worker to its own core
+  int scaling = 0;            // > 0: report strong/weak scaling at 1..scaling threads instead of rendering
+  bool worker_stats = false;  // print each render thread's busy/idle time after the render
+  int roulette_depth = 5;     // bounce Russian roulette starts at, < 0 traces every path to max depth
+  bool next_event = false;    // next-event estimation with MIS instead of the light/BSDF mixture
+  MisHeuristic mis = MisHeuristic::Power;
+  RenderEngine engine = RenderEngine::Megakernel;
+  bool sort_by_material = false;  // wavefront engine only
+  bool sort_rays = false;         // wavefront engine only
+  bool packets = false;           // wavefront engine only
+  bool specialize = true;         // sample loop compiled for the scene's features, see SceneFeatures
 };
 
 CmdOptions ParseCommandLine(int argc, char *argv[]) {
@@ -26,6 +50,57 @@ CmdOptions ParseCommandLine(int argc, char *argv[]) {
       options.samples = std::stoi(argv[++i]);
     } else if (arg == "--scene" && i + 1 < argc) {
       options.scene = std::stoi(argv[++i]);
+    } else if (arg == "--time-budget" && i + 1 < argc) {
+      options.time_budget = std::stod(argv[++i]);
+    } else if (arg == "--error-target" && i + 1 < argc) {
+      options.error_target = std::stod(argv[++i]);
+    } else if (arg == "--region" && i + 1 < argc) {
+      // x0,y0,x1,y1 in pixels, [x0, x1) x [y0, y1). Repeat for several rectangles.
+      Tile region{};
+      if (std::sscanf(argv[++i], "%d,%d,%d,%d", &region.x0, &region.y0, &region.x1, &region.y1) == 4) {
+        options.regions.push_back(region);
+      } else {
+        std::cerr << "Invalid region: " << argv[i] << " (expected x0,y0,x1,y1)" << std::endl;
+      }
+    } else if (arg == "--importance" && i + 1 < argc) {
+      options.importance = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.threads = std::stoi(argv[++i]);
+    } else if (arg == "--pin") {
+      options.pin_threads = true;
+    } else if (arg == "--worker-stats") {
+      options.worker_stats = true;
+    } else if (arg == "--scaling" && i + 1 < argc) {
+      options.scaling = std::stoi(argv[++i]);
+    } else if (arg == "--engine" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (!parse_render_engine(name, options.engine)) {
+        std::cerr << "Unknown engine: " << name << " (megakernel or wavefront)" << std::endl;
+      }
+    } else if (arg == "--sort-materials") {
+      options.sort_by_material = true;
+    } else if (arg == "--sort-rays") {
+      options.sort_rays = true;
+    } else if (arg == "--packets") {
+      options.packets = true;
+    } else if (arg == "--no-specialize") {
+      options.specialize = false;
+    } else if (arg == "--nee") {
+      options.next_event = true;
+    } else if (arg == "--mis" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (!parse_mis_heuristic(name, options.mis)) {
+        std::cerr << "Unknown MIS heuristic: " << name << " (balance or power)" << std::endl;
+      }
+    } else if (arg == "--roulette-depth" && i + 1 < argc) {
+      options.roulette_depth = std::stoi(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+    } else if (arg == "--pixel-order" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (!parse_pixel_order(name, options.pixel_order)) {
+        std::cerr << "Unknown pixel order: " << name << " (scanline, morton or hilbert)" << std::endl;
+      }
     } else {
       std::cerr << "Unknown argument: " << arg << std::endl;
     }
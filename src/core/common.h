@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -13,6 +15,17 @@ using std::make_shared;
 using std::shared_ptr;
 using std::sqrt;
 
+// Scalar of the renderer's geometry, colors and ray queues: double, or float in a build with GLIMPSE_FLOAT defined
+// (CMake's BUILD_FLOAT builds that variant next to the double one, as Glimpse_float and Glimpse_float_cli). float
+// halves the memory of BVH bounds, Film buffers and wavefront queues and doubles the lanes of a vector instruction.
+// The math core (basic_vec3, basic_ray, basic_interval, basic_aabb) is templated on it. Settings, statistics and
+// the random numbers stay double.
+#ifdef GLIMPSE_FLOAT
+using real = float;
+#else
+using real = double;
+#endif
+
 namespace math {
 // Constants
 const double infinity = std::numeric_limits<double>::infinity();
@@ -30,57 +43,98 @@ inline double clamp(double x, double min, double max) {
 }  // namespace math
 
 // The heart of our engine!
+// Counter-based: number n of a stream is a hash of the stream's key and n (SplitMix64, whose state is exactly
+// key + n·gamma). A stream is 16 bytes that can be set, saved and restored at no cost, so every sample draws from
+// its own stream, keyed by (seed, pixel, sample), with the dimension as the counter.
 class Random {
+ public:
+  // Where this thread is drawing from: the stream's key, and the dimension of the next number.
+  struct Stream {
+    uint64_t key = 0;
+    uint64_t counter = 0;
+  };
+
  private:
-  // Thread-local generator
-  static thread_local std::mt19937 generator;
+  // Thread-local stream, constant initialized so reaching it needs no check. Key 0 marks a thread that has not
+  // been keyed yet, see init_thread().
+  static constinit thread_local Stream current;
+
+  // Threads keyed by init_thread() so far, numbers their streams
+  static std::atomic<uint64_t> thread_count;
 
   // Global seed value (0 means use random seed)
   static uint32_t global_seed;
 
-  // Thread-local initialization flag
-  static thread_local bool initialized;
+  // Key of the seed, or a random one when unseeded
+  static uint64_t global_key;
+
+  static constexpr uint64_t gamma = 0x9e3779b97f4a7c15ull;
+
+  // splitmix64 step, turns nearby inputs into unrelated seeds
+  static uint64_t mix(uint64_t z) {
+    z += gamma;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  static uint64_t next() { return mix(current.key + current.counter++ * gamma); }
 
  public:
-  // Set a specific seed for deterministic results (0 means use random seed)
+  // A key nothing else will produce, for unseeded runs
+  static uint64_t random_key() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+  }
+
+  // Set a specific seed for deterministic results (0 means use random seed). Restarts this thread's stream.
   static void set_seed(uint32_t seed) {
     global_seed = seed;
+    global_key = seed != 0 ? mix(seed) : random_key();
+    current = {global_key, 0};
+  }
 
-    // If already initialized, re-seed the generator
-    if (initialized) {
-      generator.seed(seed != 0 ? seed : std::random_device{}());
-    }
+  // Keys this thread's stream from the seed and a per-thread index, unless it already has one. Threads that draw
+  // outside set_sample_stream() call this first, ThreadPool workers and the GUI's render thread do: an unkeyed
+  // stream draws the same numbers on every thread, whatever the seed. The main thread starts on the key itself.
+  static void init_thread() {
+    if (current.key != 0) return;
+    uint64_t index = thread_count.fetch_add(1, std::memory_order_relaxed);
+    current = {mix(mix(global_key) ^ index), 0};
   }
 
   // Get the current seed
   static uint32_t get_seed() { return global_seed; }
 
-  // Initialize or re-initialize the generator if needed
-  static void initialize() {
-    if (!initialized) {
-      generator.seed(global_seed != 0 ? global_seed : std::random_device{}());
-      initialized = true;
-    }
-  }
+  // Key the sample streams derive from, mixed from the seed
+  static uint64_t get_key() { return global_key; }
 
-  // Returns a random double in range [0, 1)
-  static double double_value() {
-    initialize();
-    std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    return distribution(generator);
+  // Switch this thread to the stream of (seed, pixel, sample). A sample then draws the same numbers whichever
+  // thread renders it and in whatever order, so with a seed set any part of a frame can be re-rendered
+  // bit-identically.
+  static void set_sample_stream(uint64_t pixel, uint64_t sample) {
+    current = {mix(mix(global_key ^ pixel) ^ sample), 0};
   }
 
+  // The stream as it stands, to carry on with later through set_stream(), see Wavefront
+  static Stream stream() { return current; }
+  static void set_stream(const Stream &stream) { current = stream; }
+
+  // Returns a random double in range [0, 1), from the top 53 bits
+  static double double_value() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
   // Returns a random double in range [min, max)
   static double double_value(double min, double max) { return min + (max - min) * double_value(); }
 
-  // Returns a random integer in range [min, max]
+  // Returns a random integer in range [min, max], by scaling 32 random bits (bias below range / 2^32)
   static int int_value(int min, int max) {
-    initialize();
-    std::uniform_int_distribution<int> distribution(min, max);
-    return distribution(generator);
+    uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+    return static_cast<int>(min + static_cast<int64_t>(((next() >> 32) * range) >> 32));
   }
 };
 
+constinit inline thread_local Random::Stream Random::current{};
+
 // Replace old functions with the new class methods for backward compatibility
 inline double random_double() { return Random::double_value(); }
 
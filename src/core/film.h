@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <numeric>
 #include <vector>
 
@@ -18,15 +19,22 @@ class Film {
         mean(width * height, vec3(0, 0, 0)),
         m2(width * height, vec3(0, 0, 0)) {}
 
+  // Resize to width x height and drop every accumulated sample.
   void initialize(int width, int height) {
     this->m_Width = width;
     this->m_Height = height;
-    sample_count.resize(width * height, 0);
-    accumulated_samples.resize(width * height, vec3(0, 0, 0));
-    mean.resize(width * height, vec3(0, 0, 0));
-    m2.resize(width * height, vec3(0, 0, 0));
+    sample_count.assign(width * height, 0);
+    accumulated_samples.assign(width * height, vec3(0, 0, 0));
+    mean.assign(width * height, vec3(0, 0, 0));
+    m2.assign(width * height, vec3(0, 0, 0));
   }
 
+  // Drop every accumulated sample, keeping the current size (and allocation).
+  void clear() { initialize(m_Width, m_Height); }
+
+  int width() const { return m_Width; }
+  int height() const { return m_Height; }
+
   void add_sample(int x, int y, const vec3& sample) {
     if (!isValid(x, y)) return;
     // look for and remove NaNs
@@ -34,12 +42,11 @@ class Film {
     int index = get_index(x, y);
     sample_count[index]++;
 
-    // TODO: Enable variance calcualtion after initial setup.
-    // TODO: Actually use variance map to do adaptive sampling!
-    //  vec3 delta = sample - mean[index];
-    //  mean[index] += delta / sample_count[index];
-    //  vec3 delta2 = sample - mean[index];
-    //  m2[index] += delta * delta2;
+    // Welford's online update, drives adaptive sampling.
+    vec3 delta = sample - mean[index];
+    mean[index] += delta / sample_count[index];
+    vec3 delta2 = sample - mean[index];
+    m2[index] += delta * delta2;
 
     accumulated_samples[index] += sample;
   }
@@ -71,8 +78,35 @@ class Film {
     return sample_count[index];
   }
 
+  // Relative standard error of the pixel mean, averaged over the color channels.
+  // The denominator is floored so near-black pixels don't chase an impossible relative target.
+  double get_relative_error(int x, int y) const {
+    if (!isValid(x, y)) return 0.0;
+    int index = get_index(x, y);
+    int n = sample_count[index];
+    if (n < 2) return math::infinity;
+
+    vec3 variance = m2[index] / (n - 1);
+    double standard_error = std::sqrt((variance.x() + variance.y() + variance.z()) / (3.0 * n));
+    double mean_value = (mean[index].x() + mean[index].y() + mean[index].z()) / 3.0;
+    return standard_error / std::max(mean_value, min_relative_mean);
+  }
+
+  long long get_total_sample_count() const {
+    return std::accumulate(sample_count.begin(), sample_count.end(), 0LL);
+  }
+
+  int get_min_sample_count() const {
+    return sample_count.empty() ? 0 : *std::min_element(sample_count.begin(), sample_count.end());
+  }
+
+  int get_max_sample_count() const {
+    return sample_count.empty() ? 0 : *std::max_element(sample_count.begin(), sample_count.end());
+  }
+
   int get_average_sample_count() const {
-    return int(std::accumulate(sample_count.begin(), sample_count.end(), 0) / sample_count.size());
+    if (sample_count.empty()) return 0;
+    return int(get_total_sample_count() / static_cast<long long>(sample_count.size()));
   }
 
   bool isValid(int x, int y) const { return x >= 0 && x < m_Width && y >= 0 && y < m_Height; }
@@ -89,6 +123,8 @@ class Film {
   inline int get_index(int x, int y) const { return y * m_Width + x; }
 
  private:
+  static constexpr double min_relative_mean = 0.01;
+
   int m_Width, m_Height;
   std::vector<int> sample_count;
   std::vector<vec3> accumulated_samples;
@@ -2,13 +2,10 @@
 
 using namespace glimpse;
 
-const interval interval::empty = interval(+math::infinity, -math::infinity);
-const interval interval::universe = interval(-math::infinity, +math::infinity);
-
-const aabb aabb::empty = aabb(interval::empty, interval::empty, interval::empty);
-const aabb aabb::universe = aabb(interval::universe, interval::universe, interval::universe);
-
 // Initialize static members
-thread_local std::mt19937 Random::generator;
-thread_local bool Random::initialized = false;
 uint32_t Random::global_seed = 0;
+uint64_t Random::global_key = Random::random_key();
+std::atomic<uint64_t> Random::thread_count{0};
+
+// The main thread starts on the key, so unseeded scenes still come out different every run
+static const bool main_thread_stream = (Random::set_stream({Random::get_key(), 0}), true);
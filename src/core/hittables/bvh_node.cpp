@@ -38,4 +38,22 @@ bool bvh_node::hit(const ray& r, interval ray_t, hit_record& rec) const {
   bool hit_right = right->hit(r, interval(ray_t.min, hit_left ? rec.t : ray_t.max), rec);
 
   return hit_left || hit_right;
-}
\ No newline at end of file
+}
+bool bvh_node::occluded(const ray& r, interval ray_t) const {
+  if (!bbox.hit(r, ray_t)) return false;
+
+  // Any hit will do, so the right child is only visited when the left one has none
+  return left->occluded(r, ray_t) || right->occluded(r, ray_t);
+}
+
+int bvh_node::hit_packet(const RayPacket& packet, int active, real t_min, real t_max[], hit_record recs[]) const {
+  // Lanes that miss the box drop out, the rest go down together. The left child shrinks t_max of the lanes it hits,
+  // which the right child then sees, as in hit().
+  active = bbox.hit_packet(packet, active, t_min, t_max);
+  if (active == 0) return 0;
+
+  int hit_left = left->hit_packet(packet, active, t_min, t_max, recs);
+  int hit_right = right->hit_packet(packet, active, t_min, t_max, recs);
+
+  return hit_left | hit_right;
+}
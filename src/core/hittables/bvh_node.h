@@ -20,9 +20,15 @@ class bvh_node : public hittable {
   bvh_node(std::vector<shared_ptr<hittable>>& objects, size_t start, size_t end);
 
   bool hit(const ray& r, interval ray_t, hit_record& rec) const override;
+  bool occluded(const ray& r, interval ray_t) const override;
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override;
 
   aabb bounding_box() const override { return bbox; }
 
+  bool is_moving() const override { return left->is_moving() || right->is_moving(); }
+  bool has_volume() const override { return left->has_volume() || right->has_volume(); }
+
  private:
   shared_ptr<hittable> left;
   shared_ptr<hittable> right;
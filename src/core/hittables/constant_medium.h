@@ -8,10 +8,10 @@ namespace glimpse {
 
 class constant_medium : public hittable {
  public:
-  constant_medium(shared_ptr<hittable> boundary, double density, shared_ptr<texture> tex)
+  constant_medium(shared_ptr<hittable> boundary, real density, shared_ptr<texture> tex)
       : boundary(boundary), neg_inv_density(-1 / density), phase_function(make_shared<isotropic>(tex)) {}
 
-  constant_medium(shared_ptr<hittable> boundary, double density, const color& albedo)
+  constant_medium(shared_ptr<hittable> boundary, real density, const color& albedo)
       : boundary(boundary), neg_inv_density(-1 / density), phase_function(make_shared<isotropic>(albedo)) {}
 
   bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
@@ -19,7 +19,9 @@ class constant_medium : public hittable {
 
     if (!boundary->hit(r, interval::universe, rec1)) return false;
 
-    if (!boundary->hit(r, interval(rec1.t + 0.0001, math::infinity), rec2)) return false;
+    // Past the entry point by more than its rounding error, which grows with t in float
+    real exit_start = rec1.t + std::max(real(0.0001), rounding_error(std::fabs(rec1.t)));
+    if (!boundary->hit(r, interval(exit_start, math::infinity), rec2)) return false;
 
     if (rec1.t < ray_t.min) rec1.t = ray_t.min;
     if (rec2.t > ray_t.max) rec2.t = ray_t.max;
@@ -36,6 +38,7 @@ class constant_medium : public hittable {
 
     rec.t = rec1.t + hit_distance / ray_length;
     rec.p = r.at(rec.t);
+    rec.error = 0;
 
     rec.normal = vec3(1, 0, 0);  // arbitrary
     rec.front_face = true;       // also arbitrary
@@ -46,9 +49,12 @@ class constant_medium : public hittable {
 
   aabb bounding_box() const override { return boundary->bounding_box(); }
 
+  bool is_moving() const override { return boundary->is_moving(); }
+  bool has_volume() const override { return true; }
+
  private:
   shared_ptr<hittable> boundary;
-  double neg_inv_density;
+  real neg_inv_density;
   shared_ptr<material> phase_function;
 };
 
@@ -6,14 +6,19 @@ namespace glimpse {
 
 class material;
 
+// How far rounding may put a point computed from coordinates of up to `magnitude` from the surface it lies on, see
+// hit_record::spawn_ray()
+inline real rounding_error(real magnitude) { return 16 * std::numeric_limits<real>::epsilon() * magnitude; }
+
 class hit_record {
  public:
   point3 p;
   vec3 normal;
   shared_ptr<material> mat;
-  double t{};
-  double u{};
-  double v{};
+  real t{};
+  real u{};
+  real v{};
+  real error{};  // how far p may be off the surface from the rounding of the shape's own values, see spawn_ray()
   bool front_face;
 
   void set_face_normal(const ray& r, const vec3& outward_normal) {
@@ -23,6 +28,15 @@ class hit_record {
     front_face = dot(r.direction(), outward_normal) < 0;
     normal = front_face ? outward_normal : -outward_normal;
   }
+
+  // A ray leaving the surface at p in `direction`, its origin moved off the surface along the normal, to the side it
+  // leaves by, as far as rounding could have put p on the wrong side. At a grazing angle that error alone puts the
+  // ray's next hit on the surface past any t_min. A few ulps, so it only shows in float, see real.
+  ray spawn_ray(const vec3& direction, real time) const {
+    real magnitude = std::max({real(1), std::fabs(p.x()), std::fabs(p.y()), std::fabs(p.z())});
+    real offset = std::max(rounding_error(magnitude), error);
+    return ray(dot(direction, normal) < 0 ? p - offset * normal : p + offset * normal, direction, time);
+  }
 };
 
 class hittable {
@@ -31,9 +45,34 @@ class hittable {
 
   virtual bool hit(const ray& r, interval ray_t, hit_record& rec) const = 0;
 
+  // Whether anything is hit in `ray_t`, for visibility (shadow ray) queries. Stops at the first hit found rather
+  // than the closest and fills no hit_record. By default a full hit().
+  virtual bool occluded(const ray& r, interval ray_t) const {
+    hit_record rec;
+    return hit(r, ray_t, rec);
+  }
+
+  // Packet version of hit() for the `active` lanes: lane i looks for the closest hit in (t_min, t_max[i]) and on a
+  // hit writes recs[i] and shrinks t_max[i] to it. Returns the lanes that hit. By default every lane is traced alone.
+  virtual int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[], hit_record recs[]) const {
+    int hits = 0;
+    for_each_lane(active, [&](int lane) {
+      if (hit(packet.get_ray(lane), interval(t_min, t_max[lane]), recs[lane])) {
+        t_max[lane] = recs[lane].t;
+        hits |= 1 << lane;
+      }
+    });
+    return hits;
+  }
+
   virtual aabb bounding_box() const = 0;
 
-  virtual double pdf_value(const point3& origin, const vec3& direction) const { return 0.0; }
+  // What the renderer can specialize on, see SceneFeatures: whether the geometry changes over the shutter interval,
+  // so rays need a random time, and whether it contains participating media.
+  virtual bool is_moving() const { return false; }
+  virtual bool has_volume() const { return false; }
+
+  virtual real pdf_value(const point3& origin, const vec3& direction) const { return 0.0; }
 
   virtual vec3 random(const point3& origin) const { return vec3(1, 0, 0); }
 };
@@ -57,8 +96,29 @@ class translate : public hittable {
     return true;
   }
 
+  bool occluded(const ray& r, interval ray_t) const override {
+    return object->occluded(ray(r.origin() - offset, r.direction(), r.time()), ray_t);
+  }
+
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override {
+    RayPacket offset_packet = packet;
+    for (int lane = 0; lane < RayPacket::width; lane++) {
+      offset_packet.origin_x[lane] = packet.origin_x[lane] - offset.x();
+      offset_packet.origin_y[lane] = packet.origin_y[lane] - offset.y();
+      offset_packet.origin_z[lane] = packet.origin_z[lane] - offset.z();
+    }
+
+    int hits = object->hit_packet(offset_packet, active, t_min, t_max, recs);
+    for_each_lane(hits, [&](int lane) { recs[lane].p += offset; });
+    return hits;
+  }
+
   aabb bounding_box() const override { return bbox; }
 
+  bool is_moving() const override { return object->is_moving(); }
+  bool has_volume() const override { return object->has_volume(); }
+
  private:
   shared_ptr<hittable> object;
   vec3 offset;
@@ -67,7 +127,7 @@ class translate : public hittable {
 
 class rotate_y : public hittable {
  public:
-  rotate_y(shared_ptr<hittable> object, double angle) : object(object) {
+  rotate_y(shared_ptr<hittable> object, real angle) : object(object) {
     auto radians = math::degrees_to_radians(angle);
     sin_theta = std::sin(radians);
     cos_theta = std::cos(radians);
@@ -125,12 +185,48 @@ class rotate_y : public hittable {
     return true;
   }
 
+  bool occluded(const ray& r, interval ray_t) const override {
+    auto origin = point3((cos_theta * r.origin().x()) - (sin_theta * r.origin().z()), r.origin().y(),
+                         (sin_theta * r.origin().x()) + (cos_theta * r.origin().z()));
+
+    auto direction = vec3((cos_theta * r.direction().x()) - (sin_theta * r.direction().z()), r.direction().y(),
+                          (sin_theta * r.direction().x()) + (cos_theta * r.direction().z()));
+
+    return object->occluded(ray(origin, direction, r.time()), ray_t);
+  }
+
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override {
+    RayPacket rotated = packet;
+    for (int lane = 0; lane < RayPacket::width; lane++) {
+      rotated.origin_x[lane] = (cos_theta * packet.origin_x[lane]) - (sin_theta * packet.origin_z[lane]);
+      rotated.origin_z[lane] = (sin_theta * packet.origin_x[lane]) + (cos_theta * packet.origin_z[lane]);
+      rotated.direction_x[lane] = (cos_theta * packet.direction_x[lane]) - (sin_theta * packet.direction_z[lane]);
+      rotated.direction_z[lane] = (sin_theta * packet.direction_x[lane]) + (cos_theta * packet.direction_z[lane]);
+      rotated.inv_direction_x[lane] = 1.0 / rotated.direction_x[lane];
+      rotated.inv_direction_z[lane] = 1.0 / rotated.direction_z[lane];
+    }
+
+    int hits = object->hit_packet(rotated, active, t_min, t_max, recs);
+    for_each_lane(hits, [&](int lane) {
+      hit_record& rec = recs[lane];
+      rec.p = point3((cos_theta * rec.p.x()) + (sin_theta * rec.p.z()), rec.p.y(),
+                     (-sin_theta * rec.p.x()) + (cos_theta * rec.p.z()));
+      rec.normal = vec3((cos_theta * rec.normal.x()) + (sin_theta * rec.normal.z()), rec.normal.y(),
+                        (-sin_theta * rec.normal.x()) + (cos_theta * rec.normal.z()));
+    });
+    return hits;
+  }
+
   aabb bounding_box() const override { return bbox; }
 
+  bool is_moving() const override { return object->is_moving(); }
+  bool has_volume() const override { return object->has_volume(); }
+
  private:
   shared_ptr<hittable> object;
-  double sin_theta;
-  double cos_theta;
+  real sin_theta;
+  real cos_theta;
   aabb bbox;
 };
 
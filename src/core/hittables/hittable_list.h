@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include "../aabb.h"
@@ -37,9 +38,30 @@ class hittable_list : public hittable {
     return hit_anything;
   }
 
+  bool occluded(const ray& r, interval ray_t) const override {
+    for (const auto& object : objects) {
+      if (object->occluded(r, ray_t)) return true;
+    }
+    return false;
+  }
+
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override {
+    int hits = 0;
+    for (const auto& object : objects) hits |= object->hit_packet(packet, active, t_min, t_max, recs);
+    return hits;
+  }
+
   aabb bounding_box() const override { return bbox; }
 
-  double pdf_value(const point3& origin, const vec3& direction) const override {
+  bool is_moving() const override {
+    return std::any_of(objects.begin(), objects.end(), [](const auto& object) { return object->is_moving(); });
+  }
+  bool has_volume() const override {
+    return std::any_of(objects.begin(), objects.end(), [](const auto& object) { return object->has_volume(); });
+  }
+
+  real pdf_value(const point3& origin, const vec3& direction) const override {
     // ASSERT(objects.size() > 0);
     if (objects.empty()) return 0.0;
     auto weight = 1.0 / objects.size();
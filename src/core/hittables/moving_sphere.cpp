@@ -1,5 +1,8 @@
 #include "moving_sphere.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace glimpse;
 
 bool moving_sphere::hit(const ray &r, interval ray_t, hit_record &rec) const {
@@ -9,24 +12,49 @@ bool moving_sphere::hit(const ray &r, interval ray_t, hit_record &rec) const {
   auto half_b = dot(oc, r.direction());
   auto c = oc.length_squared() - radius * radius;
 
-  auto discriminant = half_b * half_b - a * c;
+  // The discriminant and roots of sphere::find_root(), robust in float
+  vec3 l = oc - (half_b / a) * r.direction();
+  auto length = l.length();
+  auto discriminant = a * (radius - length) * (radius + length);
   if (discriminant < 0) {
     return false;
   }
   auto sqrtd = sqrt(discriminant);
+  auto q = half_b + std::copysign(sqrtd, half_b);
 
   // Find the nearest root that lies in the acceptable range.
-  auto root = (half_b - sqrtd) / a;
+  auto root = std::min(c / q, q / a);
   if (root < ray_t.min || root > ray_t.max) {
-    root = (half_b + sqrtd) / a;
+    root = std::max(c / q, q / a);
     if (root < ray_t.min || ray_t.max < root) return false;
   }
 
   rec.t = root;
   rec.p = r.at(rec.t);
+  // p is as far off the surface as the center and radius it was computed against are rounded
+  real center_magnitude =
+      std::max({std::fabs(current_center.x()), std::fabs(current_center.y()), std::fabs(current_center.z())});
+  rec.error = rounding_error(center_magnitude + radius);
   auto outward_normal = (rec.p - current_center) / radius;
   rec.set_face_normal(r, outward_normal);
   rec.mat = mat_ptr;
 
   return true;
 }
+
+bool moving_sphere::occluded(const ray &r, interval ray_t) const {
+  // The roots of hit(), without the record
+  vec3 oc = center.at(r.time()) - r.origin();
+  auto a = r.direction().length_squared();
+  auto half_b = dot(oc, r.direction());
+  auto c = oc.length_squared() - radius * radius;
+
+  vec3 l = oc - (half_b / a) * r.direction();
+  auto length = l.length();
+  auto discriminant = a * (radius - length) * (radius + length);
+  if (discriminant < 0) return false;
+  auto sqrtd = sqrt(discriminant);
+  auto q = half_b + std::copysign(sqrtd, half_b);
+
+  return ray_t.contains(c / q) || ray_t.contains(q / a);
+}
@@ -7,7 +7,7 @@ namespace glimpse {
 class moving_sphere : public hittable {
  public:
   moving_sphere() {}
-  moving_sphere(point3 cen0, point3 cen1, double r, shared_ptr<material> m)
+  moving_sphere(point3 cen0, point3 cen1, real r, shared_ptr<material> m)
       : center{cen0, cen1 - cen0}, radius{r}, mat_ptr{m} {
     auto rvec = vec3(radius, radius, radius);
     aabb box1(center.at(0) - rvec, center.at(0) + rvec);
@@ -16,13 +16,16 @@ class moving_sphere : public hittable {
   }
 
   bool hit(const ray &r, interval ray_t, hit_record &rec) const override;
+  bool occluded(const ray &r, interval ray_t) const override;
 
   aabb bounding_box() const override { return bbox; }
 
+  bool is_moving() const override { return center.direction().length_squared() > 0; }
+
  public:
   ray center;
-  double time0{}, time1{};
-  double radius{};
+  real time0{}, time1{};
+  real radius{};
   aabb bbox;
   shared_ptr<material> mat_ptr;
 };
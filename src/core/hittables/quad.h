@@ -28,33 +28,62 @@ class quad : public hittable {
   aabb bounding_box() const override { return bbox; }
 
   bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-    auto denom = dot(normal, r.direction());
-
-    // No hit if the ray is parallel to the plane.
-    if (std::fabs(denom) < 1e-8) return false;
-
-    // Return false if the hit point parameter t is outside the ray interval.
-    auto t = (D - dot(normal, r.origin())) / denom;
-    if (!ray_t.contains(t)) return false;
+    real t, alpha, beta;
+    if (!hit_plane(r, ray_t, t, alpha, beta)) return false;
 
     // Determine if the hit point lies within the planar shape using its plane coordinates.
-    auto intersection = r.at(t);
-    vec3 planar_hitpt_vector = intersection - Q;
-    auto alpha = dot(w, cross(planar_hitpt_vector, v));
-    auto beta = dot(w, cross(u, planar_hitpt_vector));
-
     if (!is_interior(alpha, beta, rec)) return false;
 
     // Ray hits the 2D shape; set the rest of the hit record and return true.
-    rec.t = t;
-    rec.p = intersection;
-    rec.mat = mat;
-    rec.set_face_normal(r, normal);
-
+    set_record(r, t, r.at(t), rec);
     return true;
   }
 
-  virtual bool is_interior(double a, double b, hit_record& rec) const {
+  bool occluded(const ray& r, interval ray_t) const override {
+    real t, alpha, beta;
+    hit_record uv;  // is_interior() writes the plane coordinates somewhere
+    return hit_plane(r, ray_t, t, alpha, beta) && is_interior(alpha, beta, uv);
+  }
+
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override {
+    // Plane hit and plane coordinates of every lane at once, with the arithmetic of hit(). is_interior() is left to
+    // the lanes that hit the plane, since shapes derived from quad override it.
+    real ts[RayPacket::width], alphas[RayPacket::width], betas[RayPacket::width];
+    real found[RayPacket::width];
+    for (int lane = 0; lane < RayPacket::width; lane++) {
+      real dir_x = packet.direction_x[lane], dir_y = packet.direction_y[lane], dir_z = packet.direction_z[lane];
+      real orig_x = packet.origin_x[lane], orig_y = packet.origin_y[lane], orig_z = packet.origin_z[lane];
+
+      real denom = normal.x() * dir_x + normal.y() * dir_y + normal.z() * dir_z;
+      real t = (D - (normal.x() * orig_x + normal.y() * orig_y + normal.z() * orig_z)) / denom;
+
+      real hitpt_x = (orig_x + t * dir_x) - Q.x();
+      real hitpt_y = (orig_y + t * dir_y) - Q.y();
+      real hitpt_z = (orig_z + t * dir_z) - Q.z();
+      alphas[lane] = w.x() * (hitpt_y * v.z() - hitpt_z * v.y()) + w.y() * (hitpt_z * v.x() - hitpt_x * v.z()) +
+                     w.z() * (hitpt_x * v.y() - hitpt_y * v.x());
+      betas[lane] = w.x() * (u.y() * hitpt_z - u.z() * hitpt_y) + w.y() * (u.z() * hitpt_x - u.x() * hitpt_z) +
+                    w.z() * (u.x() * hitpt_y - u.y() * hitpt_x);
+      ts[lane] = t;
+      found[lane] = (std::fabs(denom) >= 1e-8) & (t_min <= t) & (t <= t_max[lane]) ? 1.0 : 0.0;  // no branches
+    }
+
+    int hits = 0;
+    for (int lane = 0; lane < RayPacket::width; lane++) hits |= (found[lane] != 0 ? 1 : 0) << lane;
+    for_each_lane(hits & active, [&](int lane) {
+      if (!is_interior(alphas[lane], betas[lane], recs[lane])) {
+        hits &= ~(1 << lane);
+        return;
+      }
+      ray r = packet.get_ray(lane);
+      set_record(r, ts[lane], r.at(ts[lane]), recs[lane]);
+      t_max[lane] = ts[lane];
+    });
+    return hits & active;
+  }
+
+  virtual bool is_interior(real a, real b, hit_record& rec) const {
     interval unit_interval = interval(0, 1);
     // Given the hit point in plane coordinates, return false if it is outside the
     // primitive, otherwise set the hit record UV coordinates and return true.
@@ -66,7 +95,7 @@ class quad : public hittable {
     return true;
   }
 
-  double pdf_value(const point3& origin, const vec3& direction) const override {
+  real pdf_value(const point3& origin, const vec3& direction) const override {
     hit_record rec;
     if (!this->hit(ray(origin, direction), interval(0.001, math::infinity), rec)) return 0;
 
@@ -88,8 +117,33 @@ class quad : public hittable {
   shared_ptr<material> mat;
   aabb bbox;
   vec3 normal;
-  double D;
-  double area;
+  real D;
+  real area;
+
+  bool hit_plane(const ray& r, interval ray_t, real& t, real& alpha, real& beta) const {
+    auto denom = dot(normal, r.direction());
+
+    // No hit if the ray is parallel to the plane.
+    if (std::fabs(denom) < 1e-8) return false;
+
+    // Return false if the hit point parameter t is outside the ray interval.
+    t = (D - dot(normal, r.origin())) / denom;
+    if (!ray_t.contains(t)) return false;
+
+    // Plane coordinates of the hit point
+    vec3 planar_hitpt_vector = r.at(t) - Q;
+    alpha = dot(w, cross(planar_hitpt_vector, v));
+    beta = dot(w, cross(u, planar_hitpt_vector));
+    return true;
+  }
+
+  void set_record(const ray& r, real t, const point3& intersection, hit_record& rec) const {
+    rec.t = t;
+    rec.p = intersection;
+    rec.error = 0;  // of the size of p's coordinates
+    rec.mat = mat;
+    rec.set_face_normal(r, normal);
+  }
 };
 
 inline shared_ptr<hittable_list> box(const point3& a, const point3& b, shared_ptr<material> mat) {
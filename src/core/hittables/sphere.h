@@ -8,14 +8,14 @@ namespace glimpse {
 class sphere : public hittable {
  public:
   // Stationary Sphere
-  sphere(const point3& static_center, double radius_, shared_ptr<material> mat)
+  sphere(const point3& static_center, real radius_, shared_ptr<material> mat)
       : center(static_center, vec3(0, 0, 0)), radius(std::fmax(0, radius_)), mat(mat) {
     auto rvec = vec3(radius, radius, radius);
     bbox = aabb(static_center - rvec, static_center + rvec);
   }
 
   // Moving Sphere
-  sphere(const point3& center1, const point3& center2, double radius_, shared_ptr<material> mat)
+  sphere(const point3& center1, const point3& center2, real radius_, shared_ptr<material> mat)
       : center(center1, center2 - center1), radius(std::fmax(0, radius_)), mat(mat) {
     auto rvec = vec3(radius, radius, radius);
     aabb box1(center.at(0) - rvec, center.at(0) + rvec);
@@ -25,36 +25,67 @@ class sphere : public hittable {
 
   bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
     point3 current_center = center.at(r.time());
-    vec3 oc = current_center - r.origin();
-    auto a = r.direction().length_squared();
-    auto h = dot(r.direction(), oc);
-    auto c = oc.length_squared() - radius * radius;
+    real root;
+    if (!find_root(r, current_center, ray_t, root)) return false;
 
-    auto discriminant = h * h - a * c;
-    if (discriminant < 0) return false;
+    set_record(r, current_center, root, rec);
+    return true;
+  }
 
-    auto sqrtd = std::sqrt(discriminant);
+  bool occluded(const ray& r, interval ray_t) const override {
+    real root;
+    return find_root(r, center.at(r.time()), ray_t, root);
+  }
 
-    // Find the nearest root that lies in the acceptable range.
-    auto root = (h - sqrtd) / a;
-    if (!ray_t.surrounds(root)) {
-      root = (h + sqrtd) / a;
-      if (!ray_t.surrounds(root)) return false;
+  int hit_packet(const RayPacket& packet, int active, real t_min, real t_max[],
+                 hit_record recs[]) const override {
+    // The roots of every lane at once, with the arithmetic of hit(), then the records of the lanes that hit.
+    const real center_x = center.origin().x(), center_y = center.origin().y(), center_z = center.origin().z();
+    const real motion_x = center.direction().x(), motion_y = center.direction().y(),
+                 motion_z = center.direction().z();
+    const real radius_squared = radius * radius;
+    real roots[RayPacket::width];
+    real found[RayPacket::width];
+    for (int lane = 0; lane < RayPacket::width; lane++) {
+      real oc_x = (center_x + packet.time[lane] * motion_x) - packet.origin_x[lane];
+      real oc_y = (center_y + packet.time[lane] * motion_y) - packet.origin_y[lane];
+      real oc_z = (center_z + packet.time[lane] * motion_z) - packet.origin_z[lane];
+      real dir_x = packet.direction_x[lane], dir_y = packet.direction_y[lane], dir_z = packet.direction_z[lane];
+
+      real a = dir_x * dir_x + dir_y * dir_y + dir_z * dir_z;
+      real h = dir_x * oc_x + dir_y * oc_y + dir_z * oc_z;
+      real c = (oc_x * oc_x + oc_y * oc_y + oc_z * oc_z) - radius_squared;
+      real l_x = oc_x - (h / a) * dir_x, l_y = oc_y - (h / a) * dir_y, l_z = oc_z - (h / a) * dir_z;
+      real length = std::sqrt(l_x * l_x + l_y * l_y + l_z * l_z);
+      real discriminant = a * (radius - length) * (radius + length);
+      real sqrtd = std::sqrt(discriminant);  // NaN on lanes that miss, found[] drops them
+
+      real q = h + std::copysign(sqrtd, h);
+      real near_root = std::min(c / q, q / a);
+      real far_root = std::max(c / q, q / a);
+      // & and | rather than && and ||, which would branch
+      bool near_ok = (t_min < near_root) & (near_root < t_max[lane]);
+      bool far_ok = (t_min < far_root) & (far_root < t_max[lane]);
+      roots[lane] = near_ok ? near_root : far_root;
+      found[lane] = (discriminant >= 0) & (near_ok | far_ok) ? 1.0 : 0.0;
     }
 
-    rec.t = root;
-    rec.p = r.at(rec.t);
-    vec3 outward_normal = (rec.p - current_center) / radius;
-    rec.set_face_normal(r, outward_normal);
-    get_sphere_uv(outward_normal, rec.u, rec.v);
-    rec.mat = mat;
-
-    return true;
+    int hits = 0;
+    for (int lane = 0; lane < RayPacket::width; lane++) hits |= (found[lane] != 0 ? 1 : 0) << lane;
+    hits &= active;
+    for_each_lane(hits, [&](int lane) {
+      ray r = packet.get_ray(lane);
+      set_record(r, center.at(r.time()), roots[lane], recs[lane]);
+      t_max[lane] = roots[lane];
+    });
+    return hits;
   }
 
   aabb bounding_box() const override { return bbox; }
 
-  double pdf_value(const point3& origin, const vec3& direction) const override {
+  bool is_moving() const override { return center.direction().length_squared() > 0; }
+
+  real pdf_value(const point3& origin, const vec3& direction) const override {
     // This method only works for stationary spheres.
 
     hit_record rec;
@@ -76,11 +107,52 @@ class sphere : public hittable {
 
  private:
   ray center;
-  double radius;
+  real radius;
   shared_ptr<material> mat;
   aabb bbox;
 
-  static void get_sphere_uv(const point3& p, double& u, double& v) {
+  bool find_root(const ray& r, const point3& current_center, interval ray_t, real& root) const {
+    vec3 oc = current_center - r.origin();
+    auto a = r.direction().length_squared();
+    auto h = dot(r.direction(), oc);
+    auto c = oc.length_squared() - radius * radius;
+
+    // h² - a·c, as a·(r - |l|)·(r + |l|) with l the offset of the ray's closest point from the center: the
+    // subtraction of two nearly equal large numbers would lose most of its digits on large or far away spheres in
+    // float, this one stays small.
+    vec3 l = oc - (h / a) * r.direction();
+    auto length = l.length();
+    auto discriminant = a * (radius - length) * (radius + length);
+    if (discriminant < 0) return false;
+
+    auto sqrtd = std::sqrt(discriminant);
+
+    // The roots as q / a and c / q, neither of which subtracts h and sqrtd: they nearly cancel for a ray leaving
+    // the surface. Find the nearest root that lies in the acceptable range.
+    auto q = h + std::copysign(sqrtd, h);
+    auto near_root = std::min(c / q, q / a), far_root = std::max(c / q, q / a);
+    root = near_root;
+    if (!ray_t.surrounds(root)) {
+      root = far_root;
+      if (!ray_t.surrounds(root)) return false;
+    }
+    return true;
+  }
+
+  void set_record(const ray& r, const point3& current_center, real root, hit_record& rec) const {
+    rec.t = root;
+    rec.p = r.at(rec.t);
+    // p is as far off the surface as the center and radius it was computed against are rounded
+    real center_magnitude =
+        std::max({std::fabs(current_center.x()), std::fabs(current_center.y()), std::fabs(current_center.z())});
+    rec.error = rounding_error(center_magnitude + radius);
+    vec3 outward_normal = (rec.p - current_center) / radius;
+    rec.set_face_normal(r, outward_normal);
+    get_sphere_uv(outward_normal, rec.u, rec.v);
+    rec.mat = mat;
+  }
+
+  static void get_sphere_uv(const point3& p, real& u, real& v) {
     // p: a given point on the sphere of radius one, centered at the origin.
     // u: returned value [0,1] of angle around the Y axis from X=-1.
     // v: returned value [0,1] of angle from Y=-1 to Y=+1.
@@ -95,7 +167,7 @@ class sphere : public hittable {
     v = theta / math::pi;
   }
 
-  static vec3 random_to_sphere(double radius, double distance_squared) {
+  static vec3 random_to_sphere(real radius, real distance_squared) {
     auto r1 = random_double();
     auto r2 = random_double();
     auto z = 1 + r2 * (std::sqrt(1 - radius * radius / distance_squared) - 1);
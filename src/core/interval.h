@@ -1,47 +1,65 @@
 #pragma once
 
+#include <limits>
+#include <type_traits>
+
 #include "common.h"
 
 namespace glimpse {
 
-class interval {
+template <typename T>
+class basic_interval {
  public:
-  double min, max;
+  T min, max;
 
-  interval() : min(+math::infinity), max(-math::infinity) {}  // Default interval is empty
+  basic_interval() : min(+math::infinity), max(-math::infinity) {}  // Default interval is empty
 
-  interval(double min, double max) : min(min), max(max) {}
+  constexpr basic_interval(T min, T max) : min(min), max(max) {}
 
-  interval(const interval& a, const interval& b) {
+  basic_interval(const basic_interval& a, const basic_interval& b) {
     // Create the interval tightly enclosing the two input intervals.
     min = a.min <= b.min ? a.min : b.min;
     max = a.max >= b.max ? a.max : b.max;
   }
 
-  double size() const { return max - min; }
+  T size() const { return max - min; }
 
-  bool contains(double x) const { return min <= x && x <= max; }
+  bool contains(T x) const { return min <= x && x <= max; }
 
-  bool surrounds(double x) const { return min < x && x < max; }
+  bool surrounds(T x) const { return min < x && x < max; }
 
-  double clamp(double x) const {
+  T clamp(T x) const {
     if (x < min) return min;
     if (x > max) return max;
     return x;
   }
 
-  interval expand(double delta) const {
+  basic_interval expand(T delta) const {
     auto padding = delta / 2;
-    return interval(min - padding, max + padding);
+    return basic_interval(min - padding, max + padding);
   }
 
-  static const interval empty, universe;
+  static const basic_interval empty, universe;
 };
 
-inline interval operator+(const interval& ival, double displacement) {
-  return interval(ival.min + displacement, ival.max + displacement);
+// Constant initialized, so other statics can use them
+template <typename T>
+const basic_interval<T> basic_interval<T>::empty(std::numeric_limits<T>::infinity(),
+                                                 -std::numeric_limits<T>::infinity());
+template <typename T>
+const basic_interval<T> basic_interval<T>::universe(-std::numeric_limits<T>::infinity(),
+                                                    std::numeric_limits<T>::infinity());
+
+template <typename T>
+inline basic_interval<T> operator+(const basic_interval<T>& ival, std::type_identity_t<T> displacement) {
+  return basic_interval<T>(ival.min + displacement, ival.max + displacement);
+}
+
+template <typename T>
+inline basic_interval<T> operator+(std::type_identity_t<T> displacement, const basic_interval<T>& ival) {
+  return ival + displacement;
 }
 
-inline interval operator+(double displacement, const interval& ival) { return ival + displacement; }
+using interval = basic_interval<real>;
 
-}  // namespace glimpse
\ No newline at end of file
+}  // namespace glimpse
@@ -18,13 +18,13 @@ class material {
  public:
   virtual ~material() = default;
 
-  virtual color emitted(const ray& r_in, const hit_record& rec, double u, double v, const point3& p) const {
+  virtual color emitted(const ray& r_in, const hit_record& rec, real u, real v, const point3& p) const {
     return color(0, 0, 0);
   }
 
   virtual bool scatter(const ray& r_in, const hit_record& rec, scatter_record& srec) const { return false; }
 
-  virtual double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const { return 0; }
+  virtual real scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const { return 0; }
 };
 
 class lambertian : public material {
@@ -39,7 +39,7 @@ class lambertian : public material {
     return true;
   }
 
-  double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
+  real scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
     auto cos_theta = dot(rec.normal, unit_vector(scattered.direction()));
     return cos_theta < 0 ? 0 : cos_theta / math::pi;
   }
@@ -50,7 +50,7 @@ class lambertian : public material {
 
 class metal : public material {
  public:
-  metal(const color& albedo, double fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
+  metal(const color& albedo, real fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
 
   bool scatter(const ray& r_in, const hit_record& rec, scatter_record& srec) const override {
     vec3 reflected = reflect(r_in.direction(), rec.normal);
@@ -59,29 +59,29 @@ class metal : public material {
     srec.attenuation = albedo;
     srec.pdf_ptr = nullptr;
     srec.skip_pdf = true;
-    srec.skip_pdf_ray = ray(rec.p, reflected, r_in.time());
+    srec.skip_pdf_ray = rec.spawn_ray(reflected, r_in.time());
 
     return true;
   }
 
  private:
   color albedo;
-  double fuzz;
+  real fuzz;
 };
 
 class dielectric : public material {
  public:
-  dielectric(double refraction_index) : refraction_index(refraction_index) {}
+  dielectric(real refraction_index) : refraction_index(refraction_index) {}
 
   bool scatter(const ray& r_in, const hit_record& rec, scatter_record& srec) const override {
     srec.attenuation = color(1.0, 1.0, 1.0);
     srec.pdf_ptr = nullptr;
     srec.skip_pdf = true;
-    double ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
+    real ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
 
     vec3 unit_direction = unit_vector(r_in.direction());
-    double cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
-    double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+    real cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
+    real sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
 
     bool cannot_refract = ri * sin_theta > 1.0;
     vec3 direction;
@@ -91,16 +91,16 @@ class dielectric : public material {
     else
       direction = refract(unit_direction, rec.normal, ri);
 
-    srec.skip_pdf_ray = ray(rec.p, direction, r_in.time());
+    srec.skip_pdf_ray = rec.spawn_ray(direction, r_in.time());
     return true;
   }
 
  private:
   // Refractive index in vacuum or air, or the ratio of the material's refractive index over
   // the refractive index of the enclosing media
-  double refraction_index;
+  real refraction_index;
 
-  static double reflectance(double cosine, double refraction_index) {
+  static real reflectance(real cosine, real refraction_index) {
     // Use Schlick's approximation for reflectance.
     auto r0 = (1 - refraction_index) / (1 + refraction_index);
     r0 = r0 * r0;
@@ -113,7 +113,7 @@ class diffuse_light : public material {
   diffuse_light(shared_ptr<texture> tex) : tex(tex) {}
   diffuse_light(const color& emit) : tex(make_shared<solid_color>(emit)) {}
 
-  color emitted(const ray& r_in, const hit_record& rec, double u, double v, const point3& p) const override {
+  color emitted(const ray& r_in, const hit_record& rec, real u, real v, const point3& p) const override {
     if (!rec.front_face) return color(0, 0, 0);
     return tex->value(u, v, p);
   }
@@ -134,7 +134,7 @@ class isotropic : public material {
     return true;
   }
 
-  double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
+  real scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
     return 1 / (4 * math::pi);
   }
 
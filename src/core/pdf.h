@@ -21,7 +21,7 @@ class pdf {
  public:
   virtual ~pdf() {}
 
-  virtual double value(const vec3& direction) const = 0;
+  virtual real value(const vec3& direction) const = 0;
   virtual vec3 generate() const = 0;
 };
 
@@ -29,7 +29,7 @@ class sphere_pdf : public pdf {
  public:
   sphere_pdf() {}
 
-  double value(const vec3& direction) const override { return 1 / (4 * math::pi); }
+  real value(const vec3& direction) const override { return 1 / (4 * math::pi); }
 
   vec3 generate() const override { return random_unit_vector(); }
 };
@@ -38,7 +38,7 @@ class cosine_pdf : public pdf {
  public:
   cosine_pdf(const vec3& w) : uvw(w) {}
 
-  double value(const vec3& direction) const override {
+  real value(const vec3& direction) const override {
     auto cosine_theta = dot(unit_vector(direction), uvw.w());
     return std::fmax(0, cosine_theta / math::pi);
   }
@@ -53,7 +53,7 @@ class hittable_pdf : public pdf {
  public:
   hittable_pdf(const hittable& objects, const point3& origin) : objects(objects), origin(origin) {}
 
-  double value(const vec3& direction) const override { return objects.pdf_value(origin, direction); }
+  real value(const vec3& direction) const override { return objects.pdf_value(origin, direction); }
 
   vec3 generate() const override { return objects.random(origin); }
 
@@ -69,7 +69,7 @@ class mixture_pdf : public pdf {
     p[1] = p1;
   }
 
-  double value(const vec3& direction) const override {
+  real value(const vec3& direction) const override {
     return 0.5 * p[0]->value(direction) + 0.5 * p[1]->value(direction);
   }
 
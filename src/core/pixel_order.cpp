@@ -0,0 +1,94 @@
+#include "pixel_order.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace glimpse {
+
+// Every other bit of `bits`, packed into the low half.
+static unsigned compact_bits(unsigned bits) {
+  bits &= 0x55555555u;
+  bits = (bits | (bits >> 1)) & 0x33333333u;
+  bits = (bits | (bits >> 2)) & 0x0f0f0f0fu;
+  bits = (bits | (bits >> 4)) & 0x00ff00ffu;
+  bits = (bits | (bits >> 8)) & 0x0000ffffu;
+  return bits;
+}
+
+PixelOffset morton_decode(unsigned index) {
+  return PixelOffset{static_cast<int>(compact_bits(index)), static_cast<int>(compact_bits(index >> 1))};
+}
+
+PixelOffset hilbert_decode(int order_size, int index) {
+  int x = 0, y = 0;
+  for (int s = 1; s < order_size; s *= 2) {
+    int rx = 1 & (index / 2);
+    int ry = 1 & (index ^ rx);
+
+    // Rotate the quadrant so the curve connects to its neighbours.
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+
+    x += s * rx;
+    y += s * ry;
+    index /= 4;
+  }
+  return PixelOffset{x, y};
+}
+
+std::vector<PixelOffset> tile_traversal(PixelOrder order, int tile_size) {
+  tile_size = std::max(1, tile_size);
+
+  std::vector<PixelOffset> offsets;
+  offsets.reserve(static_cast<size_t>(tile_size) * tile_size);
+
+  if (order == PixelOrder::Scanline) {
+    // Same walk as the renderer always did: top row first.
+    for (int y = tile_size - 1; y >= 0; --y) {
+      for (int x = 0; x < tile_size; ++x) {
+        offsets.push_back(PixelOffset{x, y});
+      }
+    }
+    return offsets;
+  }
+
+  // Both curves cover a power of two square, drop what sticks out of the tile.
+  int curve_size = 1;
+  while (curve_size < tile_size) curve_size *= 2;
+
+  for (int index = 0; index < curve_size * curve_size; ++index) {
+    auto offset = order == PixelOrder::Morton ? morton_decode(static_cast<unsigned>(index))
+                                              : hilbert_decode(curve_size, index);
+    if (offset.x < tile_size && offset.y < tile_size) offsets.push_back(offset);
+  }
+  return offsets;
+}
+
+const char *to_string(PixelOrder order) {
+  switch (order) {
+    case PixelOrder::Scanline:
+      return "scanline";
+    case PixelOrder::Morton:
+      return "morton";
+    case PixelOrder::Hilbert:
+      return "hilbert";
+  }
+  return "unknown";
+}
+
+bool parse_pixel_order(const std::string &name, PixelOrder &order) {
+  for (auto candidate : {PixelOrder::Scanline, PixelOrder::Morton, PixelOrder::Hilbert}) {
+    if (name == to_string(candidate)) {
+      order = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace glimpse
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace glimpse {
+
+// Order in which a worker visits the pixels of a tile.
+// Space-filling curves keep consecutive camera rays close on screen, so they tend to walk the same BVH nodes
+// and touch the same texture lines as the ray before them.
+enum class PixelOrder {
+  Scanline,  // rows top to bottom, each row left to right
+  Morton,    // Z-order curve
+  Hilbert,   // Hilbert curve, every step moves to an edge neighbour
+};
+
+// A pixel position relative to the tile origin.
+struct PixelOffset {
+  int x, y;
+};
+
+// Offsets of a `tile_size` x `tile_size` tile in `order`. Tiles clipped by the frame edge use the same list and
+// skip the offsets that fall outside.
+std::vector<PixelOffset> tile_traversal(PixelOrder order, int tile_size);
+
+// Position of the `index`-th point on the curve.
+PixelOffset morton_decode(unsigned index);
+PixelOffset hilbert_decode(int order_size, int index);  // `order_size` is the (power of two) side of the curve
+
+const char *to_string(PixelOrder order);
+// Returns false and leaves `order` alone for unknown names.
+bool parse_pixel_order(const std::string &name, PixelOrder &order);
+
+}  // namespace glimpse
@@ -4,25 +4,29 @@
 
 namespace glimpse {
 
-class ray {
+template <typename T>
+class basic_ray {
  public:
-  ray() {}
+  basic_ray() {}
 
-  ray(const point3& origin, const vec3& direction, double time) : orig(origin), dir(direction), tm(time) {}
+  basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction, T time)
+      : orig(origin), dir(direction), tm(time) {}
 
-  ray(const point3& origin, const vec3& direction) : ray(origin, direction, 0) {}
+  basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction) : basic_ray(origin, direction, 0) {}
 
-  const point3& origin() const { return orig; }
-  const vec3& direction() const { return dir; }
+  const basic_vec3<T>& origin() const { return orig; }
+  const basic_vec3<T>& direction() const { return dir; }
 
-  double time() const { return tm; }
+  T time() const { return tm; }
 
-  point3 at(double t) const { return orig + t * dir; }
+  basic_vec3<T> at(T t) const { return orig + t * dir; }
 
  private:
-  point3 orig;
-  vec3 dir;
-  double tm{};
+  basic_vec3<T> orig;
+  basic_vec3<T> dir;
+  T tm{};
 };
 
-}  // namespace glimpse
\ No newline at end of file
+using ray = basic_ray<real>;
+
+}  // namespace glimpse
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <bit>
+
+#include "ray.h"
+
+namespace glimpse {
+
+// Up to `width` rays traced together, stored as structure of arrays so a test runs the same arithmetic on every lane
+// and compiles to vector instructions: with AVX2 four double lanes per instruction, or all eight in a float build
+// (see real), half that with SSE2. Coherent rays, such as the camera rays of neighbouring pixels, visit mostly the
+// same BVH nodes, so a packet pays one node visit for all of them. Lanes are picked with a bit mask, bit `i` for
+// lane `i`.
+struct RayPacket {
+  static constexpr int width = 8;
+
+  alignas(64) real origin_x[width]{}, origin_y[width]{}, origin_z[width]{};
+  alignas(64) real direction_x[width]{}, direction_y[width]{}, direction_z[width]{};
+  alignas(64) real inv_direction_x[width]{}, inv_direction_y[width]{}, inv_direction_z[width]{};  // slab tests
+  alignas(64) real time[width]{};
+  int count = 0;
+
+  void clear() { count = 0; }
+
+  // Adds `r` as the next lane, the packet must not be full.
+  void push(const ray &r) {
+    origin_x[count] = r.origin().x();
+    origin_y[count] = r.origin().y();
+    origin_z[count] = r.origin().z();
+    direction_x[count] = r.direction().x();
+    direction_y[count] = r.direction().y();
+    direction_z[count] = r.direction().z();
+    inv_direction_x[count] = 1.0 / r.direction().x();
+    inv_direction_y[count] = 1.0 / r.direction().y();
+    inv_direction_z[count] = 1.0 / r.direction().z();
+    time[count] = r.time();
+    count++;
+  }
+
+  int mask() const { return (1 << count) - 1; }  // every lane in use
+
+  ray get_ray(int lane) const {
+    return ray(point3(origin_x[lane], origin_y[lane], origin_z[lane]),
+               vec3(direction_x[lane], direction_y[lane], direction_z[lane]), time[lane]);
+  }
+};
+
+// Calls `f(lane)` for every lane set in `mask`, lowest first.
+template <typename F>
+void for_each_lane(int mask, F &&f) {
+  for (unsigned bits = static_cast<unsigned>(mask); bits != 0; bits &= bits - 1) f(std::countr_zero(bits));
+}
+
+}  // namespace glimpse
@@ -1,10 +1,11 @@
-
-
-#define MULTITHREADED
-#ifdef MULTITHREADED
+#include <algorithm>
+#include <chrono>
 #include <future>
+#include <iomanip>
+#include <limits>
+#include <numeric>
 #include <thread>
-#endif
+#include <utility>
 
 #include "camera.h"
 #include "common.h"
@@ -13,30 +14,166 @@
 #include "material.h"
 #include "pdf.h"
 #include "render.h"
+#include "tile_scheduler.h"
 #include "vec3.h"
+#include "wavefront.h"
 
 namespace glimpse {
 
-std::atomic<bool> Renderer::stop_rendering(false);
+// Rays traced by this thread, render_sample() turns it into per-worker progress.
+static thread_local uint64_t rays_traced = 0;
+
+// Balance or power heuristic weight of a sample with `pdf` against the other strategy's `other_pdf`
+double mis_weight(MisHeuristic heuristic, double pdf, double other_pdf) {
+  if (pdf <= 0) return 0;
+  // As a ratio, so a huge pdf (a light seen edge-on) does not overflow the power heuristic
+  double ratio = other_pdf / pdf;
+  if (heuristic == MisHeuristic::Power) ratio *= ratio;
+  return 1 / (1 + ratio);
+}
+
+// One shadow ray towards the lights, its emission weighted against the BSDF sampling the same direction
+color sample_direct_light(const ray &r_in, const hit_record &rec, const material &mat, const scatter_record &srec,
+                          const hittable &world, const hittable &lights, MisHeuristic heuristic, int &rays) {
+  ray shadow = rec.spawn_ray(lights.random(rec.p), r_in.time());
+  double light_pdf = lights.pdf_value(rec.p, shadow.direction());
+  if (light_pdf <= 0) return color(0, 0, 0);
+  double scattering_pdf = mat.scattering_pdf(r_in, rec, shadow);
+  if (scattering_pdf <= 0) return color(0, 0, 0);  // behind the surface, no need to trace it
+
+  // The emission comes from the light the sample landed on, the world only has to be clear up to it. Lights without
+  // a material only hold the shape to sample, then it takes a closest hit to find what the ray reaches.
+  rays++;
+  const double t_min = self_intersection_epsilon(rec.p);
+  hit_record light_rec;
+  if (!lights.hit(shadow, interval(t_min, math::infinity), light_rec)) return color(0, 0, 0);
+  if (light_rec.mat) {
+    // Short of the light, which is part of the world too
+    if (world.occluded(shadow, interval(t_min, light_rec.t - self_intersection_epsilon(light_rec.p)))) {
+      return color(0, 0, 0);
+    }
+  } else if (!world.hit(shadow, interval(t_min, math::infinity), light_rec)) {
+    return color(0, 0, 0);
+  }
+  color emitted = light_rec.mat->emitted(shadow, light_rec, light_rec.u, light_rec.v, light_rec.p);
+  if (emitted.length_squared() == 0) return color(0, 0, 0);
+
+  double weight = mis_weight(heuristic, light_pdf, srec.pdf_ptr->value(shadow.direction()));
+  return srec.attenuation * emitted * (scattering_pdf * weight / light_pdf);
+}
+
+// ray_color(), with every light sampling branch compiled out when `Lights` is false (see SceneFeatures).
+template <bool Lights>
+color trace_path(const ray &r, const color &background, const hittable &world, int depth, const hittable &lights,
+                 bool has_lights, const RussianRoulette &roulette, const DirectLighting &direct) {
+  // Without roulette and next-event estimation, same path and random draws as ray_color_recursive(), but the
+  // contribution of every bounce is scaled by the throughput of the path so far instead of by the return value of
+  // the next one.
+  color radiance(0, 0, 0);
+  color throughput(1, 1, 1);
+  // Throughput with the last bounce's expected weight (its albedo) in place of the sampled f * cos / pdf. Light
+  // sampling gives the rays heading for a light a low sampled weight, a roulette on that would mostly kill the
+  // rays that carry the light.
+  color expected_throughput(1, 1, 1);
+  // With next-event estimation, the BSDF pdf the current ray was sampled with, for the MIS weight of the emission
+  // it reaches. 0 for camera rays and after skip_pdf hits, which no shadow ray covers.
+  double bsdf_pdf = 0;
+  const bool lit = Lights && has_lights;
+  const bool next_event = direct.next_event_estimation && lit;
+  ray current = r;
+  hit_record rec;
+
+  for (int bounce = 0; depth >= 0; --depth, ++bounce) {
+    if (roulette.enabled && bounce >= roulette.start_depth) {
+      double survival = std::min<double>(
+          roulette.max_survival, std::max({expected_throughput.x(), expected_throughput.y(), expected_throughput.z()}));
+      if (random_double() >= survival) break;
+      throughput = throughput / survival;
+      expected_throughput = expected_throughput / survival;
+    }
+    rays_traced++;
+
+    // Start past the surface the ray leaves to avoid self-intersections
+    if (!world.hit(current, interval(self_intersection_epsilon(current.origin()), math::infinity), rec)) {
+      radiance += throughput * background;
+      break;
+    }
+
+    color emitted = rec.mat->emitted(current, rec, rec.u, rec.v, rec.p);
+    if (Lights && bsdf_pdf > 0 && emitted.length_squared() > 0) {
+      double light_pdf = lights.pdf_value(current.origin(), current.direction());
+      emitted = emitted * mis_weight(direct.heuristic, bsdf_pdf, light_pdf);
+    }
+    radiance += throughput * emitted;
+    scatter_record srec;
+    if (!rec.mat->scatter(current, rec, srec)) break;
+
+    if (srec.skip_pdf) {
+      throughput = throughput * srec.attenuation;
+      expected_throughput = throughput;
+      current = srec.skip_pdf_ray;
+      bsdf_pdf = 0;
+      continue;
+    }
+
+    ray scattered;
+    double pdf_value;
+    if (next_event) {
+      // No shadow ray on the last bounce, whose BSDF ray is not traced either: the two strategies cover the same
+      // path lengths, as in the mixture.
+      if (depth > 0) {
+        int shadow_rays = 0;
+        radiance += throughput * sample_direct_light(current, rec, *rec.mat, srec, world, lights, direct.heuristic,
+                                                     shadow_rays);
+        rays_traced += shadow_rays;
+      }
+      scattered = rec.spawn_ray(srec.pdf_ptr->generate(), current.time());
+      pdf_value = srec.pdf_ptr->value(scattered.direction());
+      bsdf_pdf = pdf_value;
+    } else if (lit) {
+      auto light_ptr = make_shared<hittable_pdf>(lights, rec.p);
+      mixture_pdf mixed_pdf(light_ptr, srec.pdf_ptr);
+      scattered = rec.spawn_ray(mixed_pdf.generate(), current.time());
+      pdf_value = mixed_pdf.value(scattered.direction());
+    } else {
+      scattered = rec.spawn_ray(srec.pdf_ptr->generate(), current.time());
+      pdf_value = srec.pdf_ptr->value(scattered.direction());
+    }
+
+    double scattering_pdf = rec.mat->scattering_pdf(current, rec, scattered);
+    expected_throughput = throughput * srec.attenuation;
+    throughput = throughput * srec.attenuation * scattering_pdf / pdf_value;
+    current = scattered;
+  }
+
+  return radiance;
+}
 
-// Recursive ray tracing with depth limiting
 color ray_color(const ray &r, const color &background, const hittable &world, int depth, const hittable &lights,
-                bool has_lights) {
+                bool has_lights, const RussianRoulette &roulette, const DirectLighting &direct) {
+  return trace_path<true>(r, background, world, depth, lights, has_lights, roulette, direct);
+}
+
+// Recursive ray tracing with depth limiting
+color ray_color_recursive(const ray &r, const color &background, const hittable &world, int depth,
+                          const hittable &lights, bool has_lights) {
   hit_record rec;
 
   // if we've exceeded the ray bounce limit, no more light is gathered
   if (depth < 0) return color(0, 0, 0);
+  rays_traced++;
 
   // If the ray hits nothing, return the background color.
-  // Use eps = 0.001 to avoid self-intersections
-  if (world.hit(r, interval{0.001, math::infinity}, rec)) {
+  // Start past the surface the ray leaves to avoid self-intersections
+  if (world.hit(r, interval(self_intersection_epsilon(r.origin()), math::infinity), rec)) {
     scatter_record srec;
     color color_from_emission = rec.mat->emitted(r, rec, rec.u, rec.v, rec.p);
 
     // Scattered reflectance
     if (rec.mat->scatter(r, rec, srec)) {
       if (srec.skip_pdf) {
-        return srec.attenuation * ray_color(srec.skip_pdf_ray, background, world, depth - 1, lights, has_lights);
+        return srec.attenuation *
+               ray_color_recursive(srec.skip_pdf_ray, background, world, depth - 1, lights, has_lights);
       }
 
       ray scattered;
@@ -44,16 +181,16 @@ color ray_color(const ray &r, const color &background, const hittable &world, in
       if (has_lights) {
         auto light_ptr = make_shared<hittable_pdf>(lights, rec.p);
         mixture_pdf mixed_pdf(light_ptr, srec.pdf_ptr);
-        scattered = ray(rec.p, mixed_pdf.generate(), r.time());
+        scattered = rec.spawn_ray(mixed_pdf.generate(), r.time());
         pdf_value = mixed_pdf.value(scattered.direction());
       } else {
-        scattered = ray(rec.p, srec.pdf_ptr->generate(), r.time());
+        scattered = rec.spawn_ray(srec.pdf_ptr->generate(), r.time());
         pdf_value = srec.pdf_ptr->value(scattered.direction());
       }
 
       double scattering_pdf = rec.mat->scattering_pdf(r, rec, scattered);
 
-      color sample_color = ray_color(scattered, background, world, depth - 1, lights, has_lights);
+      color sample_color = ray_color_recursive(scattered, background, world, depth - 1, lights, has_lights);
 
       color color_from_scatter = (srec.attenuation * scattering_pdf * sample_color) / pdf_value;
 
@@ -79,98 +216,399 @@ vec3 sample_square_stratified(int s_i, int s_j, double recip_sqrt_spp) {
   return vec3(px, py, 0);
 }
 
-struct RenderSectionArgs {
+struct RenderContext;
+struct RenderPass;
+
+// Traces a pass over a tile, see render_tile() and render_tile_wavefront().
+using TileRenderer = void (*)(const RenderContext &ctx, const Tile &tile, const RenderPass &pass,
+                              RenderProgress::Counters *counters);
+
+struct RenderContext {
   Image &image;  // Image output, filled with rgb values
   Film &film;    // Intermediate buffer, accumulates samples and computes variance.
-  int start_row;
-  int end_row;
   const Scene &scene;
-  const bvh_node &world_bvh;
-  std::atomic<int> *progress;
+  const hittable &world_bvh;
+  const RenderSettings &settings;
+  RenderProgress *progress;
+  int stratum_stride;                                  // see stratum_stride_for()
+  const std::vector<unsigned char> *active_pixels{};  // adaptive passes only sample these
+  const std::vector<int> *pixel_budget{};              // sample count each pixel should end up with
+  CancelToken cancel{};
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  std::vector<PixelOffset> pixel_order{};  // tile_traversal() for the settings
+  bool has_lights = false;                 // Scene::lights is not empty
+  TileRenderer render_tile{};              // compiled for the scene's SceneFeatures, see tile_renderer_for()
 };
 
-void render_section(RenderSectionArgs &args) {
-  auto &image = args.image;
-  auto &cam = args.scene.cam;
-  auto &start_row = args.start_row;
-  auto &end_row = args.end_row;
-  auto &world_bvh = args.world_bvh;
-  auto &scene = args.scene;
-  auto progress = args.progress;
-  auto &film = args.film;
-
-  for (int s_j = 0; s_j < cam.sqrt_spp; ++s_j) {
-    for (int s_i = 0; s_i < cam.sqrt_spp; ++s_i) {
-      for (int j = end_row - 1; j >= start_row; --j) {
-        for (int i = 0; i < cam.image_width; ++i) {
-          // color pixel_color(0, 0, 0);
-          color pixel_color(0, 0, 0);
-
-          auto offset = sample_square_stratified(s_i, s_j, cam.recip_sqrt_spp);
-          auto u = (i + offset.x()) / (cam.image_width - 1);
-          auto v = (j + offset.y()) / (cam.image_height - 1);
-          ray r = cam.get_ray(u, v);
-          pixel_color +=
-              ray_color(r, scene.background, world_bvh, cam.max_depth, scene.lights, !scene.lights.objects.empty());
-          if (progress) (*progress)++;
-
-          film.add_sample(i, j, pixel_color);
-          pixel_color = film.get_sample(i, j);
-          pixel_color = sqrt(pixel_color);  // gamma correction!
-          // image.set(i, j, ImageColor{float(pixel_color.x()), float(pixel_color.y()), float(pixel_color.z())});
-          image.set_float(i, j, static_cast<float>(pixel_color.x()), static_cast<float>(pixel_color.y()),
-                          static_cast<float>(pixel_color.z()));
-        }
+// Checked before every sample: either the render was cancelled or the time budget ran out.
+inline bool should_stop(const RenderContext &ctx) {
+  if (ctx.cancel.is_cancelled()) return true;
+  return ctx.deadline != std::chrono::steady_clock::time_point::max() &&
+         std::chrono::steady_clock::now() >= ctx.deadline;
+}
+
+// What one sweep over the frame does to each pixel.
+struct RenderPass {
+  int samples;            // samples added to each pixel
+  bool adaptive = false;  // only sample RenderContext::active_pixels, see RenderSettings::adaptive_sampling
+  bool budgeted = false;  // stop each pixel at its RenderContext::pixel_budget, see RenderSettings::importance
+};
+
+// Pixels walk their strata with a stride co-prime to the stratum count. A full cycle still visits every
+// stratum once, but any prefix (min_spp, an adaptive batch, a cancelled uncapped pass) is spread over the
+// pixel instead of bunching up in the first rows of the sub-pixel grid.
+int stratum_stride_for(int strata) {
+  int stride = std::max(1, static_cast<int>(strata * 0.6180339887));
+  while (std::gcd(stride, strata) != 1) ++stride;
+  return stride;
+}
+
+// Camera ray of sample `sample_index` of pixel (i, j), with the random stream set up for that sample.
+// Each pixel continues its stratum sequence where its sample count left off.
+template <SceneFeatures F>
+inline ray camera_ray(const RenderContext &ctx, int i, int j, long long sample_index) {
+  auto &cam = ctx.scene.cam;
+
+  const int sqrt_spp = std::max(1, cam.sqrt_spp);
+  const int strata = sqrt_spp * sqrt_spp;
+
+  Random::set_sample_stream(ctx.film.get_index(i, j), sample_index);
+
+  int stratum = static_cast<int>((sample_index * ctx.stratum_stride) % strata);
+  int s_i = stratum % sqrt_spp;
+  int s_j = stratum / sqrt_spp;
+
+  auto offset = sample_square_stratified(s_i, s_j, cam.recip_sqrt_spp);
+  auto u = (i + offset.x()) / (cam.image_width - 1);
+  auto v = (j + offset.y()) / (cam.image_height - 1);
+  return cam.get_ray<F.defocus, F.motion>(u, v);
+}
+
+// Traces one more sample for pixel (i, j) and adds it to the Film, the image is resolved separately.
+template <SceneFeatures F>
+inline void render_sample(const RenderContext &ctx, RenderProgress::Counters *counters, int i, int j) {
+  auto &scene = ctx.scene;
+
+  ray r = camera_ray<F>(ctx, i, j, ctx.film.get_sample_count(i, j));
+  const uint64_t rays_before = rays_traced;
+  color pixel_color = trace_path<F.lights>(r, scene.background, ctx.world_bvh, scene.cam.max_depth, scene.lights,
+                                           ctx.has_lights, ctx.settings.roulette, ctx.settings.direct_lighting);
+  if (counters) counters->add_sample(rays_traced - rays_before);
+
+  ctx.film.add_sample(i, j, pixel_color);
+}
+
+inline int adaptive_max_spp(const RenderSettings &settings, const camera &cam) {
+  return settings.max_spp > 0 ? settings.max_spp : cam.sqrt_spp * cam.sqrt_spp;
+}
+
+// Writes the Film under `tiles` to the image, gamma corrected.
+void resolve_image(const Film &film, const std::vector<Tile> &tiles, Image &image) {
+  for (auto &tile : tiles) {
+    for (int j = tile.y0; j < tile.y1; ++j) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        auto pixel_color = sqrt(film.get_sample(i, j));
+        image.set_float(i, j, static_cast<float>(pixel_color.x()), static_cast<float>(pixel_color.y()),
+                        static_cast<float>(pixel_color.z()));
+      }
+    }
+  }
+}
+
+SampleSummary summarize(const Film &film, const std::vector<Tile> &tiles) {
+  SampleSummary summary;
+  summary.min_spp = std::numeric_limits<int>::max();
+
+  long long pixels = 0;
+  for (auto &tile : tiles) {
+    for (int j = tile.y0; j < tile.y1; ++j) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        int n = film.get_sample_count(i, j);
+        summary.total_samples += n;
+        summary.min_spp = std::min(summary.min_spp, n);
+        summary.max_spp = std::max(summary.max_spp, n);
+        summary.relative_error += film.get_relative_error(i, j);
+      }
+    }
+    pixels += tile.pixel_count();
+  }
+
+  if (pixels == 0) return SampleSummary{};
+  summary.relative_error /= pixels;
+  return summary;
+}
+
+// Spp of the next progressive pass: 1 spp first, then double the frame each pass, at most `max_pass` at a time.
+inline int progressive_batch(int spp, int max_pass) { return std::clamp(spp, 1, std::max(1, max_pass)); }
+
+// Size of the next error-target pass. The relative error falls as 1/sqrt(spp), so extrapolate the spp that
+// would hit the target, but never more than double the frame at once: early estimates are noisy.
+int error_target_batch(const SampleSummary &summary, double target, int max_spp) {
+  const int spp = summary.min_spp;
+  if (spp < 2) return 2 - spp;
+
+  const double error = summary.relative_error;
+
+  double ratio = error / target;
+  long long needed = static_cast<long long>(std::ceil(spp * ratio * ratio)) - spp;
+  long long batch = std::clamp<long long>(needed, 1, spp);
+  if (max_spp > 0) batch = std::min<long long>(batch, max_spp - spp);
+  return static_cast<int>(batch);
+}
+
+std::vector<int> allocate_samples(const std::vector<float> &importance, const std::vector<Tile> &tiles, int width,
+                                  long long budget, int max_spp) {
+  std::vector<int> spp(importance.size(), 0);
+  const long long cap = max_spp > 0 ? max_spp : std::numeric_limits<int>::max();
+
+  long long pixels = 0;
+  double total_weight = 0;
+  for (auto &tile : tiles) {
+    pixels += tile.pixel_count();
+    for (int j = tile.y0; j < tile.y1; ++j) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        total_weight += std::max(0.0f, importance[j * width + i]);
+      }
+    }
+  }
+  if (pixels == 0) return spp;
+
+  // One sample each, so no pixel is left black, then the rest in proportion to the weights.
+  // Largest remainder rounding keeps the total exactly on budget.
+  const long long rest = std::max(0LL, budget - pixels);
+  std::vector<std::pair<double, int>> remainders;
+  remainders.reserve(pixels);
+
+  long long assigned = 0;
+  for (auto &tile : tiles) {
+    for (int j = tile.y0; j < tile.y1; ++j) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        const int index = j * width + i;
+        double weight = total_weight > 0 ? std::max(0.0f, importance[index]) / total_weight : 1.0 / pixels;
+        double share = rest * weight;
+        auto whole = static_cast<long long>(share);
+
+        spp[index] = static_cast<int>(std::min(1 + whole, cap));
+        assigned += whole;
+        remainders.push_back({share - whole, index});
       }
     }
   }
-  std::cout << "Section done ... rows[" << start_row << ", " << end_row << "] thread " << std::this_thread::get_id()
-            << std::endl;
-}
-
-void render_section_uncap(RenderSectionArgs &args) {
-  auto &image = args.image;
-  auto &cam = args.scene.cam;
-  auto &start_row = args.start_row;
-  auto &end_row = args.end_row;
-  auto &world_bvh = args.world_bvh;
-  auto &scene = args.scene;
-  auto progress = args.progress;
-  auto &film = args.film;
-
-  while (!Renderer::stop_rendering.load()) {
-    for (int s_j = 0; s_j < cam.sqrt_spp; ++s_j) {
-      for (int s_i = 0; s_i < cam.sqrt_spp; ++s_i) {
-        for (int j = end_row - 1; j >= start_row; --j) {
-          for (int i = 0; i < cam.image_width; ++i) {
-            // color pixel_color(0, 0, 0);
-            color pixel_color(0, 0, 0);
-
-            auto offset = sample_square_stratified(s_i, s_j, cam.recip_sqrt_spp);
-            auto u = (i + offset.x()) / (cam.image_width - 1);
-            auto v = (j + offset.y()) / (cam.image_height - 1);
-            ray r = cam.get_ray(u, v);
-            pixel_color +=
-                ray_color(r, scene.background, world_bvh, cam.max_depth, scene.lights, !scene.lights.objects.empty());
-            if (progress) (*progress)++;
-
-            film.add_sample(i, j, pixel_color);
-            pixel_color = film.get_sample(i, j);
-            pixel_color = sqrt(pixel_color);  // gamma correction!
-            // image.set(i, j, ImageColor{float(pixel_color.x()), float(pixel_color.y()), float(pixel_color.z())});
-            image.set_float(i, j, static_cast<float>(pixel_color.x()), static_cast<float>(pixel_color.y()),
-                            static_cast<float>(pixel_color.z()));
+
+  auto leftover = static_cast<size_t>(std::min<long long>(rest - assigned, remainders.size()));
+  std::partial_sort(remainders.begin(), remainders.begin() + leftover, remainders.end(),
+                    [](auto &a, auto &b) { return a.first > b.first; });
+  for (size_t k = 0; k < leftover; ++k) {
+    if (spp[remainders[k].second] < cap) spp[remainders[k].second]++;
+  }
+
+  return spp;
+}
+
+std::vector<float> importance_from_image(const Image &weights) {
+  std::vector<float> importance(static_cast<size_t>(weights.width) * weights.height);
+  for (int y = 0; y < weights.height; ++y) {
+    for (int x = 0; x < weights.width; ++x) {
+      auto c = weights.get_float(x, y);
+      importance[static_cast<size_t>(y) * weights.width + x] = static_cast<float>((c.x() + c.y() + c.z()) / 3.0);
+    }
+  }
+  return importance;
+}
+
+// Marks the pixels the next adaptive pass should sample and returns how many there are.
+// A pixel counts as converged only when its whole 3x3 neighbourhood is below the noise threshold: a handful of
+// samples that all missed a small light look perfectly noise free, its neighbours usually don't.
+// Neighbours outside the rendered regions have no samples and are ignored.
+// Runs between passes, while no worker is writing to the Film.
+long long update_active_pixels(const Film &film, const std::vector<Tile> &tiles, const RenderSettings &settings,
+                               int max_spp, std::vector<unsigned char> &active) {
+  active.assign(static_cast<size_t>(film.width()) * film.height(), 0);
+
+  long long count = 0;
+  for (auto &tile : tiles) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      for (int x = tile.x0; x < tile.x1; ++x) {
+        int n = film.get_sample_count(x, y);
+        if (n >= max_spp) continue;
+
+        bool converged = n >= std::max(1, settings.min_spp);
+        for (int dy = -1; converged && dy <= 1; ++dy) {
+          for (int dx = -1; converged && dx <= 1; ++dx) {
+            if (!film.isValid(x + dx, y + dy) || film.get_sample_count(x + dx, y + dy) == 0) continue;
+            converged = film.get_relative_error(x + dx, y + dy) < settings.noise_threshold;
           }
         }
+
+        if (!converged) {
+          active[film.get_index(x, y)] = 1;
+          count++;
+        }
       }
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
-  std::cout << "Stopping section ... rows[" << start_row << ", " << end_row << "] thread " << std::this_thread::get_id()
-            << std::endl;
+  return count;
+}
+
+// Calls `add_sample(i, j)` for every sample `pass` adds to the tile, pixels in RenderSettings::pixel_order, until
+// it returns false.
+template <typename AddSample>
+void for_each_sample(const RenderContext &ctx, const Tile &tile, const RenderPass &pass, AddSample &&add_sample) {
+  if (!pass.adaptive && !pass.budgeted) {
+    // Sample-major, so a partially rendered tile is evenly refined.
+    for (int s = 0; s < pass.samples; ++s) {
+      for (auto offset : ctx.pixel_order) {
+        int i = tile.x0 + offset.x, j = tile.y0 + offset.y;
+        if (i >= tile.x1 || j >= tile.y1) continue;
+
+        if (!add_sample(i, j)) return;
+      }
+    }
+    return;
+  }
+
+  // Per-pixel limits: up to `pass.samples` more, without going past the pixel's own cap.
+  const int max_spp = adaptive_max_spp(ctx.settings, ctx.scene.cam);
+  for (auto offset : ctx.pixel_order) {
+    int i = tile.x0 + offset.x, j = tile.y0 + offset.y;
+    if (i >= tile.x1 || j >= tile.y1) continue;
+
+    const int index = ctx.film.get_index(i, j);
+    int limit = max_spp;
+    if (pass.budgeted) {
+      limit = (*ctx.pixel_budget)[index];
+    } else if (!(*ctx.active_pixels)[index]) {
+      continue;
+    }
+
+    int samples = std::min(pass.samples, limit - ctx.film.get_sample_count(i, j));
+    for (int s = 0; s < samples; ++s) {
+      if (!add_sample(i, j)) return;
+    }
+  }
+}
+
+// Megakernel engine: every sample traced on its own, stopping before any of them.
+template <SceneFeatures F>
+void render_tile(const RenderContext &ctx, const Tile &tile, const RenderPass &pass,
+                 RenderProgress::Counters *counters) {
+  for_each_sample(ctx, tile, pass, [&](int i, int j) {
+    if (should_stop(ctx)) return false;
+    render_sample<F>(ctx, counters, i, j);
+    return true;
+  });
+}
+
+// Wavefront engine: the tile's samples are queued into waves of RenderSettings::wave_size paths. A wave is traced
+// as a whole and its samples are added to the Film in the order they were queued, stopping between waves.
+template <SceneFeatures F>
+void render_tile_wavefront(const RenderContext &ctx, const Tile &tile, const RenderPass &pass,
+                           RenderProgress::Counters *counters) {
+  static thread_local Wavefront wave;
+  static thread_local std::vector<PixelOffset> wave_pixels;  // pixel of each path, relative to the tile
+  static thread_local std::vector<int> queued;               // samples of each tile pixel already in the wave
+
+  auto &scene = ctx.scene;
+  const int wave_size = std::max(1, ctx.settings.wave_size);
+  queued.assign(tile.pixel_count(), 0);
+  wave.begin();
+  wave_pixels.clear();
+
+  auto flush = [&]() {
+    if (should_stop(ctx)) return false;
+    wave.trace(ctx.world_bvh, scene.background, scene.lights, F.lights && ctx.has_lights, scene.cam.max_depth,
+               ctx.settings);
+    for (int path = 0; path < wave.size(); ++path) {
+      if (counters) counters->add_sample(wave.rays_traced(path));
+      ctx.film.add_sample(tile.x0 + wave_pixels[path].x, tile.y0 + wave_pixels[path].y, wave.radiance(path));
+    }
+
+    wave.begin();
+    wave_pixels.clear();
+    std::fill(queued.begin(), queued.end(), 0);
+    return true;
+  };
+
+  for_each_sample(ctx, tile, pass, [&](int i, int j) {
+    if (wave.size() >= wave_size && !flush()) return false;
+
+    const PixelOffset offset{i - tile.x0, j - tile.y0};
+    int &pending = queued[offset.y * tile.width() + offset.x];
+    wave.add_path(camera_ray<F>(ctx, i, j, ctx.film.get_sample_count(i, j) + pending));
+    pending++;
+    wave_pixels.push_back(offset);
+    return true;
+  });
+  if (wave.size() > 0) flush();
+}
+
+// The tile loop of `engine` compiled for `features`, one flag at a time: `Flags` holds the lights, motion and
+// defocus flags decided so far.
+template <bool... Flags>
+TileRenderer tile_renderer_for(RenderEngine engine, const SceneFeatures &features) {
+  if constexpr (sizeof...(Flags) == 3) {
+    constexpr SceneFeatures F{Flags...};
+    return engine == RenderEngine::Wavefront ? &render_tile_wavefront<F> : &render_tile<F>;
+  } else {
+    const bool flags[] = {features.lights, features.motion, features.defocus};
+    return flags[sizeof...(Flags)] ? tile_renderer_for<Flags..., true>(engine, features)
+                                   : tile_renderer_for<Flags..., false>(engine, features);
+  }
+}
+
+// Pulls tiles (own queue first, then stolen ones) until the frame is drained or rendering is stopped.
+void render_worker(const RenderContext &ctx, TileScheduler &scheduler, int worker, const RenderPass &pass,
+                   WorkerStats &stats) {
+  auto *counters = ctx.progress ? &ctx.progress->worker(worker) : nullptr;
+
+  Tile tile;
+  bool stolen = false;
+  while (!should_stop(ctx) && scheduler.next(worker, tile, stolen)) {
+    auto start = std::chrono::steady_clock::now();
+    ctx.render_tile(ctx, tile, pass, counters);
+    stats.busy_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    scheduler.finish(tile);
+    if (counters && !should_stop(ctx)) counters->add_work_unit();
+
+    stats.tiles++;
+    if (stolen) stats.tiles_stolen++;
+  }
+}
+
+// Runs `pass` over the whole frame and blocks until every worker is done, calling `on_tick` with the tiles
+// finished since the last call every RenderSettings::resolve_interval seconds while it waits.
+void render_pass(const RenderContext &ctx, ThreadPool &pool, TileScheduler &scheduler, const RenderPass &pass,
+                 std::vector<WorkerStats> &stats, const std::function<void(const std::vector<Tile> &)> &on_tick) {
+  const int num_workers = scheduler.num_workers();
+  scheduler.reset();
+
+  std::vector<double> busy_before(num_workers);
+  for (int w = 0; w < num_workers; ++w) busy_before[w] = stats[w].busy_seconds;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::future<void>> futures;
+  for (int w = 0; w < num_workers; ++w) {
+    futures.push_back(pool.submit([&, w]() {  //
+      render_worker(ctx, scheduler, w, pass, stats[w]);
+    }));
+  }
+  const auto interval = std::chrono::duration<double>(ctx.settings.resolve_interval);
+  for (auto &f : futures) {
+    if (interval.count() > 0) {
+      while (f.wait_for(interval) != std::future_status::ready) on_tick(scheduler.take_finished());
+    }
+    f.get();
+  }
+
+  // Whatever part of the pass a worker did not spend tracing, it spent waiting on the slowest one.
+  auto pass_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (int w = 0; w < num_workers; ++w) {
+    stats[w].idle_seconds += std::max(0.0, pass_seconds - (stats[w].busy_seconds - busy_before[w]));
+  }
 }
 
-void Renderer::render_scene(Scene scene, Image &image, std::atomic<int> *progress) {
+void Renderer::render_scene(Scene scene, Image &image, RenderProgress *progress, CancelToken cancel) {
   auto world_bvh = bvh_node(scene.world);
 
   film.initialize(scene.cam.image_width, scene.cam.image_height);
@@ -178,51 +616,335 @@ void Renderer::render_scene(Scene scene, Image &image, std::atomic<int> *progres
   // Fixed seed!
   // Random::set_seed(42);
 
-#ifdef MULTITHREADED
-  const int num_threads = std::thread::hardware_concurrency();
-  std::vector<std::future<void>> futures;
-  int rows_per_thread = scene.cam.image_height / num_threads;
-
-  for (int t = 0; t < num_threads; ++t) {
-    int start_row = t * rows_per_thread;
-    int end_row = (t == num_threads - 1) ? scene.cam.image_height : start_row + rows_per_thread;
-
-    RenderSectionArgs args{image, film, start_row, end_row, scene, world_bvh, progress};
-    if (scene.cam.uncapped_spp) {
-      futures.push_back(                  //
-          std::async(std::launch::async,  //
-                     [args]() mutable {   //
-                       render_section_uncap(args);
-                     }));
+  render(scene, world_bvh, image, progress, std::move(cancel));
+}
+
+void Renderer::render(const Scene &scene, const hittable &world, Image &image, RenderProgress *progress,
+                      CancelToken cancel) {
+  const int wanted_threads = settings.num_threads > 0
+                                 ? settings.num_threads
+                                 : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  if (!pool || pool->size() != wanted_threads || pool_pinned != settings.pin_threads) {
+    pool.reset();  // joins the old workers first
+    pool = std::make_unique<ThreadPool>(wanted_threads, settings.pin_threads);
+    pool_pinned = settings.pin_threads;
+    if (settings.pin_threads && !pool->pinned()) {
+      if (!quiet) std::cout << "Could not pin the render threads, running unpinned" << std::endl;
+    }
+  }
+
+  const int num_threads = pool->size();
+  auto scheduler = settings.regions.empty()
+                       ? TileScheduler(scene.cam.image_width, scene.cam.image_height, settings.tile_size, num_threads)
+                       : TileScheduler(scene.cam.image_width, scene.cam.image_height, settings.tile_size, num_threads,
+                                       settings.regions);
+  const auto &tiles = scheduler.tiles();
+  worker_stats.assign(num_threads, WorkerStats{});
+
+  const int samples_per_pixel = scene.cam.sqrt_spp * scene.cam.sqrt_spp;
+  if (progress) progress->start(num_threads);
+
+  RenderContext ctx{image, film, scene, world, settings, progress, stratum_stride_for(std::max(1, samples_per_pixel))};
+  ctx.cancel = std::move(cancel);
+  ctx.pixel_order = tile_traversal(settings.pixel_order, settings.tile_size);
+  ctx.has_lights = !scene.lights.objects.empty();
+  ctx.render_tile =
+      tile_renderer_for(settings.engine, settings.specialize ? SceneFeatures::of(scene) : SceneFeatures{});
+
+  auto start = std::chrono::steady_clock::now();
+  frame_stats = FrameStats{};
+  for (auto &tile : tiles) frame_stats.pixels += tile.pixel_count();
+
+  auto update_frame_stats = [&]() {
+    frame_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto summary = summarize(film, tiles);
+    frame_stats.total_samples = summary.total_samples;
+    frame_stats.min_spp = summary.min_spp;
+    frame_stats.max_spp = summary.max_spp;
+    frame_stats.relative_error = summary.relative_error;
+  };
+
+  // Every mode goes through here, so finished passes are published the same way.
+  const bool resolve_passes = on_frame || settings.resolve_interval > 0;
+  // Mid-pass, only the tiles the workers are done with, the others are still being written.
+  auto resolve_finished = [&](const std::vector<Tile> &finished) { resolve_image(film, finished, image); };
+  auto run_pass = [&](const RenderPass &pass) {
+    render_pass(ctx, *pool, scheduler, pass, worker_stats, resolve_finished);
+    frame_stats.passes++;
+    if (should_stop(ctx)) return;  // partial pass, not a frame
+
+    if (resolve_passes) resolve_image(film, tiles, image);
+    if (on_frame) {
+      update_frame_stats();
+      on_frame(image, frame_stats);
+    }
+  };
+
+  // Modes don't combine, say which requested ones this render drops
+  if (auto modes = sampling_modes(settings, scene.cam.uncapped_spp); modes.size() > 1 && !quiet) {
+    std::cout << "Rendering in " << modes[0] << " mode, ignoring";
+    for (size_t k = 1; k < modes.size(); ++k) std::cout << " " << modes[k];
+    std::cout << std::endl;
+  }
+
+  if (settings.time_budget > 0) {
+    ctx.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(settings.time_budget));
+  }
+
+  if (settings.error_target > 0) {
+    // Whole-frame passes sized from the current error, until the frame as a whole is converged enough.
+    const int max_spp = settings.max_spp > 0     ? settings.max_spp
+                        : settings.time_budget > 0 ? 0  // the deadline bounds it
+                                                   : settings.error_target_max_spp;
+    while (!should_stop(ctx)) {
+      auto summary = summarize(film, tiles);
+      if (summary.min_spp >= 2 && summary.relative_error < settings.error_target) break;
+
+      int batch = error_target_batch(summary, settings.error_target, max_spp);
+      if (batch <= 0) {
+        frame_stats.spp_capped = true;
+        break;
+      }
+
+      run_pass(RenderPass{batch});
+    }
+  } else if (settings.time_budget > 0) {
+    // One sample per pixel per pass, so whenever the deadline hits the frame is evenly refined.
+    while (!should_stop(ctx)) {
+      run_pass(RenderPass{1});
+    }
+  } else if (settings.progressive) {
+    // 1, 1, 2, 4, ... spp per pass.
+    int rendered = 0;
+    while (!should_stop(ctx) && (scene.cam.uncapped_spp || rendered < samples_per_pixel)) {
+      int batch = progressive_batch(rendered, samples_per_pixel);
+      if (!scene.cam.uncapped_spp) batch = std::min(batch, samples_per_pixel - rendered);
+
+      run_pass(RenderPass{batch});
+      rendered += batch;
+    }
+  } else if (scene.cam.uncapped_spp) {
+    // Keep sweeping the whole frame until asked to stop.
+    while (!should_stop(ctx)) {
+      run_pass(RenderPass{samples_per_pixel});
+    }
+  } else if (!settings.importance.empty()) {
+    // Fixed total budget, spread by the importance map. Doubling passes as in progressive mode, so a
+    // cancelled render is still refined in proportion.
+    std::vector<int> pixel_budget;
+    if (settings.importance.size() == static_cast<size_t>(film.width()) * film.height()) {
+      const long long budget = static_cast<long long>(samples_per_pixel) * frame_stats.pixels;
+      pixel_budget = allocate_samples(settings.importance, tiles, film.width(), budget, settings.max_spp);
     } else {
-      futures.push_back(                  //
-          std::async(std::launch::async,  //
-                     [args]() mutable {   //
-                       render_section(args);
-                     }));
+      if (!quiet) {
+        std::cout << "Importance map is " << settings.importance.size() << " pixels, expected "
+                  << film.width() * film.height() << ", rendering uniformly" << std::endl;
+      }
+      pixel_budget.assign(static_cast<size_t>(film.width()) * film.height(), samples_per_pixel);
     }
+    // On top of whatever a RenderSession already accumulated
+    for (auto &tile : tiles) {
+      for (int j = tile.y0; j < tile.y1; ++j) {
+        for (int i = tile.x0; i < tile.x1; ++i) {
+          auto &allowance = pixel_budget[film.get_index(i, j)];
+          const long long total = static_cast<long long>(allowance) + film.get_sample_count(i, j);
+          allowance = static_cast<int>(std::min<long long>(total, std::numeric_limits<int>::max()));
+        }
+      }
+    }
+    ctx.pixel_budget = &pixel_budget;
+
+    const int max_budget = *std::max_element(pixel_budget.begin(), pixel_budget.end());
+    for (int allowance = 0; !should_stop(ctx) && allowance < max_budget;) {
+      int batch = progressive_batch(allowance, max_budget);
+      run_pass(RenderPass{batch, false, true});
+      allowance += batch;
+    }
+  } else if (settings.adaptive_sampling) {
+    // Uniform pre-pass to get a variance estimate everywhere, then keep topping up the noisy pixels
+    // until every pixel has converged or hit max_spp.
+    // Below one sample the pre-pass leaves pixels empty and the batches never converge anything
+    const int max_spp = adaptive_max_spp(settings, scene.cam);
+    const int batch = std::max(1, settings.adaptive_batch);
+    run_pass(RenderPass{std::clamp(settings.min_spp, 1, max_spp)});
+
+    std::vector<unsigned char> active_pixels;
+    ctx.active_pixels = &active_pixels;
+    while (!should_stop(ctx) && update_active_pixels(film, tiles, settings, max_spp, active_pixels) > 0) {
+      run_pass(RenderPass{batch, true});
+    }
+
+    if (!quiet) {
+      auto budget = static_cast<long long>(max_spp) * frame_stats.pixels;
+      auto total = summarize(film, tiles).total_samples;
+      std::cout << "Adaptive sampling: " << total << " samples, " << (budget > 0 ? 100.0 * total / budget : 0.0)
+                << "% of the " << max_spp << " spp budget" << std::endl;
+    }
+  } else {
+    run_pass(RenderPass{samples_per_pixel});
   }
 
-  // Wait for a signal to stop rendering before waiting for threaads to finish.
-  // while (!stop_rendering.load()) {
-  //   std::this_thread::sleep_for(std::chrono::milliseconds(10));
-  // }
+  resolve_image(film, tiles, image);  // also whatever a cancelled pass got to
+  update_frame_stats();
+  if (ctx.cancel.is_cancelled()) {
+    frame_stats.stop_latency =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx.cancel.cancel_time()).count();
+    if (!quiet) {
+      std::cout << "Cancelled, stopped " << 1000.0 * frame_stats.stop_latency << " ms after the request" << std::endl;
+    }
+  }
 
-  for (auto &f : futures) {
-    f.get();
+  if (quiet) return;
+  if (settings.error_target > 0) {
+    std::cout << "Error target: " << frame_stats.relative_error << " of " << settings.error_target << " after "
+              << frame_stats.passes << " passes, " << frame_stats.average_spp() << " spp"
+              << (frame_stats.spp_capped ? ", stopped at the spp cap" : "") << std::endl;
+  } else if (settings.time_budget > 0) {
+    std::cout << "Time budget: " << frame_stats.seconds << " of " << settings.time_budget << " s, "
+              << frame_stats.passes << " passes, " << frame_stats.total_samples << " samples, "
+              << frame_stats.average_spp() << " spp (" << frame_stats.min_spp << " to "
+              << frame_stats.max_spp << " per pixel)" << std::endl;
   }
 
   // TODO: Implement __FUNCTION__ logging with logger!?..
   // control logging from the logger class
   std::cout << __FUNCTION__ << " : All threads finished rendering..." << std::endl;
-  Renderer::stop_rendering = false;
-#else  // SINGLETHREADED
+}
+
+SceneFeatures SceneFeatures::of(const Scene &scene) {
+  SceneFeatures features;
+  features.lights = !scene.lights.objects.empty();
+  features.motion = scene.world.is_moving();
+  features.defocus = scene.cam.has_defocus();
+  features.volumes = scene.world.has_volume();
+  return features;
+}
+
+std::string to_string(const SceneFeatures &features) {
+  std::string names;
+  for (auto [present, name] : {std::pair{features.lights, "lights"}, std::pair{features.motion, "motion"},
+                               std::pair{features.defocus, "defocus"}, std::pair{features.volumes, "volumes"}}) {
+    if (!present) continue;
+    if (!names.empty()) names += "+";
+    names += name;
+  }
+  return names.empty() ? "none" : names;
+}
+
+const char *to_string(RenderEngine engine) {
+  switch (engine) {
+    case RenderEngine::Megakernel:
+      return "megakernel";
+    case RenderEngine::Wavefront:
+      return "wavefront";
+  }
+  return "unknown";
+}
+
+bool parse_render_engine(const std::string &name, RenderEngine &engine) {
+  for (auto candidate : {RenderEngine::Megakernel, RenderEngine::Wavefront}) {
+    if (name == to_string(candidate)) {
+      engine = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *to_string(MisHeuristic heuristic) {
+  switch (heuristic) {
+    case MisHeuristic::Balance:
+      return "balance";
+    case MisHeuristic::Power:
+      return "power";
+  }
+  return "unknown";
+}
+
+bool parse_mis_heuristic(const std::string &name, MisHeuristic &heuristic) {
+  for (auto candidate : {MisHeuristic::Balance, MisHeuristic::Power}) {
+    if (name == to_string(candidate)) {
+      heuristic = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<const char *> sampling_modes(const RenderSettings &settings, bool uncapped) {
+  std::vector<const char *> modes;
+  if (settings.error_target > 0) modes.push_back("error-target");
+  if (settings.time_budget > 0 && settings.error_target <= 0) modes.push_back("time-budget");
+  if (settings.progressive) modes.push_back("progressive");
+  if (uncapped && modes.empty()) modes.push_back("uncapped");
+  if (!settings.importance.empty()) modes.push_back("importance");
+  if (settings.adaptive_sampling) modes.push_back("adaptive");
+  return modes;
+}
+
+void Renderer::resolve(Image &image) const {
+  resolve_image(film, {Tile{0, 0, film.width(), film.height()}}, image);
+}
 
-  // Image image(image_width, image_height);
-  render_section(image, 0, image_height, image_width, image_height, samples_per_pixel, cam, background, world_bvh,
-                 max_depth);
+void Renderer::print_worker_stats(std::ostream &out) const {
+  auto flags = out.flags();
+  auto precision = out.precision();
+
+  double busy = 0, idle = 0;
+  int tiles = 0, stolen = 0;
+
+  out << "worker |  tiles | stolen |   busy (s) |   idle (s) | busy %\n";
+  for (size_t w = 0; w < worker_stats.size(); ++w) {
+    auto &s = worker_stats[w];
+    out << std::setw(6) << w << " | " << std::setw(6) << s.tiles << " | " << std::setw(6) << s.tiles_stolen << " | "
+        << std::fixed << std::setprecision(3) << std::setw(10) << s.busy_seconds << " | " << std::setw(10)
+        << s.idle_seconds << " | " << std::setprecision(1) << std::setw(6) << 100.0 * s.utilization() << "\n";
+    busy += s.busy_seconds;
+    idle += s.idle_seconds;
+    tiles += s.tiles;
+    stolen += s.tiles_stolen;
+  }
+  auto total = busy + idle;
+  out << " total | " << std::setw(6) << tiles << " | " << std::setw(6) << stolen << " | " << std::setprecision(3)
+      << std::setw(10) << busy << " | " << std::setw(10) << idle << " | " << std::setprecision(1) << std::setw(6)
+      << (total > 0 ? 100.0 * busy / total : 0.0) << std::endl;
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void RenderSession::set_scene(Scene scene) {
+  m_Scene = std::move(scene);
+  m_WorldBvh = std::make_unique<bvh_node>(m_Scene.world);
+  m_ResetFilm = true;
+}
+
+void RenderSession::update_camera(const camera &cam) {
+  m_Scene.cam = cam;
+  m_ResetFilm = true;
+}
+
+void RenderSession::update_background(const color &background) {
+  m_Scene.background = background;
+  m_ResetFilm = true;
+}
+
+void RenderSession::update_settings(const RenderSettings &settings) {
+  m_Renderer.settings = settings;
+  m_ResetFilm = true;
+}
+
+void RenderSession::render(Image &image, RenderProgress *progress, CancelToken cancel) {
+  if (!m_WorldBvh) return;
+
+  auto &film = m_Renderer.film;
+  if (m_ResetFilm || film.width() != m_Scene.cam.image_width || film.height() != m_Scene.cam.image_height) {
+    film.initialize(m_Scene.cam.image_width, m_Scene.cam.image_height);
+    m_ResetFilm = false;
+  }
 
-#endif
+  m_Renderer.render(m_Scene, *m_WorldBvh, image, progress, std::move(cancel));
 }
 
 }  // namespace glimpse
\ No newline at end of file
@@ -1,24 +1,300 @@
 #pragma once
 
-#include <atomic>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "cancel_token.h"
 #include "film.h"
+#include "hittables/bvh_node.h"
 #include "image.h"
+#include "material.h"
+#include "pixel_order.h"
+#include "render_progress.h"
 #include "scenes.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
 
 namespace glimpse {
 
+// Russian roulette path termination. From bounce `start_depth` on, a path continues with a probability equal to
+// the largest component of its throughput, at most `max_survival`, and survivors are weighted up by it, so dim
+// paths stop early without biasing the image. The last bounce counts with its albedo rather than its sampled
+// weight, see ray_color().
+struct RussianRoulette {
+  bool enabled = true;
+  int start_depth = 5;         // bounces every path gets, the camera ray is bounce 0
+  double max_survival = 0.95;  // even bright paths stop now and then, bounding the expected length
+
+  bool operator==(const RussianRoulette &) const = default;
+};
+
+// Multiple importance sampling heuristic: how a sample that two strategies could have drawn is weighted by its own
+// strategy's pdf against the other's.
+enum class MisHeuristic {
+  Balance,  // pdf / (pdf + other)
+  Power,    // pdf^2 / (pdf^2 + other^2), closer to the better strategy where one clearly wins
+};
+
+const char *to_string(MisHeuristic heuristic);
+// Returns false and leaves `heuristic` alone for unknown names.
+bool parse_mis_heuristic(const std::string &name, MisHeuristic &heuristic);
+
+// Weight of a sample drawn with density `pdf` that the other strategy draws with density `other_pdf`.
+double mis_weight(MisHeuristic heuristic, double pdf, double other_pdf);
+
+// Direct lighting in scenes with lights (Scene::lights). By default every diffuse hit (not skip_pdf) continues in
+// one direction picked from the lights or the BSDF 50/50 (mixture_pdf). With next-event estimation, every diffuse
+// hit that has a bounce after it also traces a shadow ray to a point sampled on the lights, and the path continues
+// by BSDF sampling alone. Emission reached both ways is MIS weighted, so neither strategy counts it twice and each
+// covers the lights where it samples well: small or distant lights for the shadow ray, glossy lobes for the BSDF.
+struct DirectLighting {
+  bool next_event_estimation = false;
+  MisHeuristic heuristic = MisHeuristic::Power;
+
+  bool operator==(const DirectLighting &) const = default;
+};
+
+// Next-event estimation at a diffuse hit of `r_in`: one shadow ray from rec.p towards a point sampled on `lights`,
+// returning the emission it reaches times the BSDF (scattering_pdf x attenuation) over the light pdf, MIS weighted
+// against sampling srec.pdf_ptr. Scale by the path throughput. Adds the shadow ray, if one was traced, to `rays`.
+color sample_direct_light(const ray &r_in, const hit_record &rec, const material &mat, const scatter_record &srec,
+                          const hittable &world, const hittable &lights, MisHeuristic heuristic, int &rays);
+
 // declared here for testing only
 color ray_color(const ray &r, const color &background, const hittable &world,  //
-                int depth, const hittable &lights, bool has_lights);
+                int depth, const hittable &lights, bool has_lights, const RussianRoulette &roulette = {},
+                const DirectLighting &direct = {});
+// The original recursive integrator, kept as the reference ray_color() is tested against.
+color ray_color_recursive(const ray &r, const color &background, const hittable &world,  //
+                          int depth, const hittable &lights, bool has_lights);
 vec3 sample_square_stratified(int s_i, int s_j, double recip_sqrt_spp);
 
+// Splits `budget` samples over the pixels under `tiles` in proportion to `importance` (row-major, `width` wide).
+// Every pixel gets at least one sample and the counts add up to `budget` exactly, unless a pixel's share is
+// capped at `max_spp` (when positive, else at what an int holds), which drops the samples above the cap.
+std::vector<int> allocate_samples(const std::vector<float> &importance, const std::vector<Tile> &tiles, int width,
+                                  long long budget, int max_spp = 0);
+
+// Film statistics over the pixels being rendered, the whole frame or just the requested regions.
+struct SampleSummary {
+  long long total_samples = 0;
+  int min_spp = 0;
+  int max_spp = 0;
+  double relative_error = 0;  // mean of Film::get_relative_error(), the frame error error_target stops on
+};
+
+SampleSummary summarize(const Film &film, const std::vector<Tile> &tiles);
+
+// Importance map from a weight image, the average of its channels.
+std::vector<float> importance_from_image(const Image &weights);
+
+// How the samples of a tile are traced.
+enum class RenderEngine {
+  Megakernel,  // one sample at a time, each path followed to its end by ray_color()
+  Wavefront,   // batches of paths advanced one stage at a time, see Wavefront
+};
+
+const char *to_string(RenderEngine engine);
+// Returns false and leaves `engine` alone for unknown names.
+bool parse_render_engine(const std::string &name, RenderEngine &engine);
+
+// What a scene uses of the integrator and the camera. Each render runs the sample loop compiled for its scene's
+// features (RenderSettings::specialize), so a scene without lights, motion or depth of field pays for them neither
+// a branch per bounce nor a random draw per camera ray. Defaults to everything, the variant any scene can use.
+struct SceneFeatures {
+  bool lights = true;   // Scene::lights is not empty: light sampling
+  bool motion = true;   // some geometry moves over the shutter interval (hittable::is_moving()): random ray times
+  bool defocus = true;  // camera::defocus_angle > 0: rays start on the lens
+  // Participating media (hittable::has_volume()). Reported only: a medium draws its scattering distance inside
+  // constant_medium::hit(), there is nothing in the sample loop to compile out.
+  bool volumes = true;
+
+  static SceneFeatures of(const Scene &scene);
+};
+
+// "lights+motion+defocus+volumes", the features present, or "none".
+std::string to_string(const SceneFeatures &features);
+
+// How a frame is cut up and scheduled. Scene content and sample counts live on the camera.
+struct RenderSettings {
+  int num_threads = 0;       // render workers, 0 uses every hardware thread
+  bool pin_threads = false;  // bind worker i to logical CPU i, where the platform supports it
+  int tile_size = 16;        // edge length, in pixels, of the square tiles handed to workers
+  PixelOrder pixel_order = PixelOrder::Scanline;  // walk inside each tile
+
+  // Adaptive sampling (capped renders only). Every pixel first gets `min_spp` samples, then keeps receiving
+  // batches of `adaptive_batch` samples until its relative error drops below `noise_threshold` or it
+  // reaches `max_spp`. `min_spp` and `adaptive_batch` below 1 count as 1.
+  bool adaptive_sampling = false;
+  int min_spp = 16;
+  int max_spp = 0;  // 0 uses the camera's samples_per_pixel
+  int adaptive_batch = 8;
+  double noise_threshold = 0.1;
+
+  // Deadline mode. When positive, the frame is refined one sample per pixel at a time until `time_budget`
+  // seconds have passed, regardless of the camera's samples per pixel. Workers stop at the next sample
+  // boundary, so no pixel is more than one sample behind any other when the deadline hits.
+  double time_budget = 0;
+
+  // Error-target mode. When positive, whole-frame passes continue until the mean relative error (summarize())
+  // drops below `error_target`, regardless of the camera's samples per pixel. `max_spp` caps it when set and a
+  // time budget still applies as a deadline. With neither, it stops at `error_target_max_spp`: fireflies can keep
+  // a tight target out of reach for good. FrameStats::spp_capped tells when a cap ended it.
+  double error_target = 0;
+  int error_target_max_spp = 4096;
+
+  // Progressive mode (capped and uncapped renders). The frame starts with a 1 spp pass and every following pass
+  // doubles its spp, up to the camera's samples per pixel per pass, so the first frames arrive quickly and every
+  // published frame is complete and evenly sampled.
+  bool progressive = false;
+
+  // Workers only accumulate into the Film, the image is resolved from it after the render, after every completed
+  // pass when someone is watching (on_frame or this interval) and, when positive, every `resolve_interval`
+  // seconds while a pass runs. Mid-pass resolves only pick up the tiles finished so far, never one still being
+  // written.
+  double resolve_interval = 0;
+
+  // Region of interest. When not empty, only the pixels inside these rectangles are rendered (overlaps once),
+  // the rest of the Film and image is left alone. Frame statistics and stopping rules only look at the regions.
+  // With Random::set_seed() the regions come out bit-identical to the same pixels of a full-frame render,
+  // except with adaptive sampling, whose neighbourhood test sees different neighbours at the region edges.
+  std::vector<Tile> regions;
+
+  // Importance map (capped renders). Row-major weights, one per pixel; when set, the frame's budget of
+  // samples_per_pixel x pixels is spread in proportion to them instead of evenly, with at least one sample per
+  // pixel. See importance_from_image() to paint it as an image.
+  std::vector<float> importance;
+
+  RussianRoulette roulette;
+  DirectLighting direct_lighting;
+  // Run the sample loop compiled for the scene's SceneFeatures, picked once per render. Off runs the generic
+  // variant, which draws a random time for every camera ray and checks for lights and the lens at runtime.
+  bool specialize = true;
+
+  RenderEngine engine = RenderEngine::Megakernel;
+  // Wavefront engine: paths per wave. Workers check for cancellation and the deadline between waves, so a
+  // stop takes up to one wave per worker.
+  int wave_size = 4096;
+  // Wavefront engine: shade each bounce's hits grouped by material type, and within a type by material instance
+  // (and with it texture), rather than in the order the rays landed, so runs of hits go through the same shading
+  // code and texture data.
+  bool sort_by_material = false;
+  // Wavefront engine: intersect each bounce's secondary rays ordered by direction octant and origin (a Morton code
+  // within the scene bounds) rather than in path order, so consecutive rays tend to walk the same BVH nodes.
+  bool sort_rays = false;
+  // Wavefront engine: intersect camera rays in packets of neighbouring pixels (RayPacket), which share the BVH
+  // nodes they visit. Later bounces are incoherent and go one ray at a time, as do all rays of scenes with volumes.
+  bool packet_camera_rays = false;
+
+  bool operator==(const RenderSettings &) const = default;
+};
+
+// The sampling modes `settings` asks for, with a camera that is `uncapped` (camera::uncapped_spp) or not, in the
+// order Renderer::render() gives them precedence: "error-target", "time-budget", "progressive", "uncapped",
+// "importance" and "adaptive". Only the first one runs, the others are ignored. A time budget alongside an error
+// target is its deadline and an uncapped camera under a time budget, error target or progressive passes just lifts
+// the cap, so neither is listed then. Empty renders the camera's samples per pixel in one pass.
+std::vector<const char *> sampling_modes(const RenderSettings &settings, bool uncapped);
+
+// Sample counts reached by the last render, see Renderer::frame_stats.
+struct FrameStats {
+  long long pixels = 0;         // pixels rendered, the whole frame or RenderSettings::regions
+  int passes = 0;               // sweeps over the frame, the last one may be partial
+  double seconds = 0;           // wall-clock time of the render
+  long long total_samples = 0;  // samples in the Film, including earlier renders of a RenderSession
+  int min_spp = 0;              // lowest per-pixel sample count
+  int max_spp = 0;              // highest per-pixel sample count
+  double relative_error = 0;    // mean of Film::get_relative_error() at the end of the render
+  double stop_latency = 0;      // seconds from CancelToken::cancel() to the render returning, if it was cancelled
+  bool spp_capped = false;      // error-target mode stopped at its spp cap, short of the target
+
+  double average_spp() const { return pixels > 0 ? static_cast<double>(total_samples) / pixels : 0.0; }
+};
+
+// Load balance of a single worker thread over the last render.
+struct WorkerStats {
+  int tiles = 0;            // tiles rendered by this worker
+  int tiles_stolen = 0;     // tiles taken from another worker's queue
+  double busy_seconds = 0;  // time spent tracing tiles
+  double idle_seconds = 0;  // time spent waiting for the other workers to finish the pass
+
+  double utilization() const {
+    auto total = busy_seconds + idle_seconds;
+    return total > 0 ? busy_seconds / total : 0.0;
+  }
+};
+
+// Called from the render thread after every completed pass, once `image` holds the resolved frame.
+using FrameCallback = std::function<void(const Image &image, const FrameStats &stats)>;
+
 class Renderer {
  public:
-  void render_scene(Scene scene, Image &image, std::atomic<int> *progress = nullptr);
-  static std::atomic<bool> stop_rendering;
+  // One-shot render: builds the BVH for `scene`, resets the Film and renders the frame.
+  void render_scene(Scene scene, Image &image, RenderProgress *progress = nullptr, CancelToken cancel = {});
+
+  // Renders `scene` against an already built acceleration structure, accumulating into the Film as it is.
+  // The caller owns both, see RenderSession.
+  //
+  // `cancel` stops only this render. Workers check it before every sample, so the render returns within one
+  // sample per worker plus the between-pass bookkeeping (FrameStats::stop_latency). Renderers share no state,
+  // several of them can run and be cancelled independently.
+  void render(const Scene &scene, const hittable &world, Image &image, RenderProgress *progress = nullptr,
+              CancelToken cancel = {});
+
+  // Converts the Film to `image`, gamma corrected. Not while a render is running, see
+  // RenderSettings::resolve_interval for that.
+  void resolve(Image &image) const;
+
+  // Per-thread busy/idle table of the last render. render() doesn't print it, the CLI does with --worker-stats.
+  void print_worker_stats(std::ostream &out) const;
 
+  RenderSettings settings;
   Film film;
+  std::vector<WorkerStats> worker_stats;
+  FrameStats frame_stats;
+  FrameCallback on_frame;
+  // Keeps render() from reporting on std::cout, for callers running many renders (scaling runs, benchmarks).
+  bool quiet = false;
+
+ private:
+  // Started on first use and kept until the thread settings change.
+  std::unique_ptr<ThreadPool> pool;
+  bool pool_pinned = false;  // RenderSettings::pin_threads the pool was started with
+};
+
+// Long-lived render state for interactive use. Keeps the worker pool, the scene BVH and the Film alive
+// between renders, so a camera or parameter change only resets the Film instead of rebuilding everything.
+class RenderSession {
+ public:
+  // Load a new scene, this is the only call that (re)builds the BVH.
+  void set_scene(Scene scene);
+
+  // Updates that keep the BVH. Each one restarts accumulation on the next render().
+  void update_camera(const camera &cam);
+  void update_background(const color &background);
+  void update_settings(const RenderSettings &settings);
+
+  // Doesn't reset anything, see Renderer::on_frame.
+  void set_frame_callback(FrameCallback callback) { m_Renderer.on_frame = std::move(callback); }
+
+  // Render with the current state. Samples keep accumulating across calls until something is updated,
+  // so a cancelled uncapped render can be resumed.
+  void render(Image &image, RenderProgress *progress = nullptr, CancelToken cancel = {});
+
+  const Scene &scene() const { return m_Scene; }
+  const RenderSettings &settings() const { return m_Renderer.settings; }
+  const Film &film() const { return m_Renderer.film; }
+  const std::vector<WorkerStats> &worker_stats() const { return m_Renderer.worker_stats; }
+  const FrameStats &frame_stats() const { return m_Renderer.frame_stats; }
+
+ private:
+  Renderer m_Renderer;
+  Scene m_Scene;
+  std::unique_ptr<bvh_node> m_WorldBvh;
+  bool m_ResetFilm = true;
 };
 
-}  // namespace glimpse
\ No newline at end of file
+}  // namespace glimpse
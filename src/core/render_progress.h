@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace glimpse {
+
+// Totals of a render in flight, see RenderProgress::snapshot().
+struct ProgressSnapshot {
+  uint64_t samples = 0;     // camera samples added to the Film
+  uint64_t rays = 0;        // rays traced, camera rays and every bounce
+  uint64_t work_units = 0;  // tiles finished
+};
+
+// Progress of one render, readable from any thread while it runs.
+// Every worker counts into its own cache line and is the only one writing to it, so the sample loop never
+// contends with other workers or with readers. Readers add the counters up when they ask.
+class RenderProgress {
+ public:
+  // One worker's counters. Only that worker writes them, so plain load + store is enough.
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> rays{0};
+    std::atomic<uint64_t> work_units{0};
+
+    void add_sample(uint64_t rays_traced) {
+      samples.store(samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      rays.store(rays.load(std::memory_order_relaxed) + rays_traced, std::memory_order_relaxed);
+    }
+    void add_work_unit() {
+      work_units.store(work_units.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  };
+
+  // Called by the renderer before its workers start: `num_workers` zeroed counters.
+  void start(int num_workers) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (num_workers > m_Capacity) {
+      m_Counters = std::make_unique<Counters[]>(num_workers);
+      m_Capacity = num_workers;
+    }
+    for (int w = 0; w < m_Capacity; ++w) {
+      m_Counters[w].samples = 0;
+      m_Counters[w].rays = 0;
+      m_Counters[w].work_units = 0;
+    }
+    m_Workers = num_workers;
+  }
+
+  // Valid between start() and the next start().
+  Counters &worker(int index) { return m_Counters[index]; }
+
+  ProgressSnapshot snapshot() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ProgressSnapshot total;
+    for (int w = 0; w < m_Workers; ++w) {
+      total.samples += m_Counters[w].samples.load(std::memory_order_relaxed);
+      total.rays += m_Counters[w].rays.load(std::memory_order_relaxed);
+      total.work_units += m_Counters[w].work_units.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+ private:
+  mutable std::mutex m_Mutex;  // guards the array itself, never taken by workers
+  std::unique_ptr<Counters[]> m_Counters;
+  int m_Capacity = 0;
+  int m_Workers = 0;
+};
+
+}  // namespace glimpse
@@ -0,0 +1,102 @@
+#include "scaling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+#include "hittables/bvh_node.h"
+
+namespace glimpse {
+
+std::vector<int> scaling_thread_counts(int max_threads) {
+  max_threads = std::max(1, max_threads);
+
+  std::vector<int> counts;
+  for (int n = 1; n < max_threads; n *= 2) counts.push_back(n);
+  counts.push_back(max_threads);
+  return counts;
+}
+
+// Times one capped render of `scene` on `threads` workers.
+static ScalingPoint measure(const Scene &scene, const hittable &world, int threads, const RenderSettings &settings) {
+  Renderer renderer;
+  renderer.settings = settings;
+  renderer.settings.num_threads = threads;
+  renderer.quiet = true;  // keep the table readable
+  renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+  Image image(scene.cam.image_width, scene.cam.image_height);
+  renderer.render(scene, world, image);
+
+  ScalingPoint point;
+  point.threads = threads;
+  point.seconds = renderer.frame_stats.seconds;
+  point.samples = renderer.frame_stats.total_samples;
+  return point;
+}
+
+ScalingReport run_scaling(const Scene &scene, int max_threads, RenderSettings settings) {
+  // Fixed amount of work: the whole frame as the camera asks for it, evenly sampled in one pass.
+  settings.time_budget = 0;
+  settings.error_target = 0;
+  settings.adaptive_sampling = false;
+  settings.progressive = false;
+  settings.resolve_interval = 0;
+  settings.importance.clear();
+  settings.regions.clear();
+
+  Scene frame = scene;
+  frame.cam.uncapped_spp = false;
+  frame.cam.initialize();
+  bvh_node world(frame.world);
+
+  ScalingReport report;
+  for (int threads : scaling_thread_counts(max_threads)) {
+    report.strong.push_back(measure(frame, world, threads, settings));
+
+    // The camera renders square sample counts, take the closest one to spp x threads.
+    Scene weak = frame;
+    int sqrt_spp = static_cast<int>(std::lround(std::sqrt(double(frame.cam.samples_per_pixel) * threads)));
+    weak.cam.samples_per_pixel = std::max(1, sqrt_spp * sqrt_spp);
+    weak.cam.initialize();
+    report.weak.push_back(measure(weak, world, threads, settings));
+  }
+
+  // Throughput relative to one thread. For strong scaling that is T(1) / T(n); for weak scaling it also
+  // absorbs the rounding of the grown sample count.
+  auto finish = [](std::vector<ScalingPoint> &points) {
+    auto throughput = [](const ScalingPoint &p) { return p.seconds > 0 ? p.samples / p.seconds : 0.0; };
+    const double base = throughput(points.front());
+    for (auto &point : points) {
+      point.speedup = base > 0 ? throughput(point) / base : 0.0;
+      point.efficiency = point.speedup / point.threads;
+    }
+  };
+  finish(report.strong);
+  finish(report.weak);
+  return report;
+}
+
+void print_scaling_report(const ScalingReport &report, std::ostream &out) {
+  auto flags = out.flags();
+  auto precision = out.precision();
+
+  auto table = [&](const char *title, const std::vector<ScalingPoint> &points) {
+    out << title << "\n";
+    out << "threads |   time (s) |    samples/s | speedup | efficiency\n";
+    for (auto &p : points) {
+      out << std::setw(7) << p.threads << " | " << std::fixed << std::setprecision(3) << std::setw(10) << p.seconds
+          << " | " << std::setprecision(0) << std::setw(12) << (p.seconds > 0 ? p.samples / p.seconds : 0.0)
+          << " | " << std::setprecision(2) << std::setw(7) << p.speedup << " | " << std::setprecision(1)
+          << std::setw(9) << 100.0 * p.efficiency << "%\n";
+    }
+  };
+  table("Strong scaling (same frame)", report.strong);
+  table("Weak scaling (samples per pixel x threads)", report.weak);
+  out << std::flush;
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+}  // namespace glimpse
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <iosfwd>
+#include <vector>
+
+#include "render.h"
+
+namespace glimpse {
+
+// One thread count of a scaling run.
+struct ScalingPoint {
+  int threads = 0;
+  double seconds = 0;
+  long long samples = 0;
+  double speedup = 0;     // samples/s relative to one thread
+  double efficiency = 0;  // speedup / threads
+};
+
+struct ScalingReport {
+  std::vector<ScalingPoint> strong;  // the same frame at every thread count
+  std::vector<ScalingPoint> weak;    // samples per pixel grow with the thread count, same work per thread
+};
+
+// Thread counts a scaling run measures: powers of two up to `max_threads`, and `max_threads` itself.
+std::vector<int> scaling_thread_counts(int max_threads);
+
+// Renders `scene` (capped, with its camera's samples per pixel) at 1..max_threads workers, once for strong and
+// once for weak scaling. `settings` is used for everything but the thread count and the sampling mode: time
+// budget, error target, adaptive, progressive, importance and regions are all reset.
+ScalingReport run_scaling(const Scene &scene, int max_threads, RenderSettings settings = {});
+
+void print_scaling_report(const ScalingReport &report, std::ostream &out);
+
+}  // namespace glimpse
@@ -216,9 +216,8 @@ Scene cornell_box() {
   box2 = make_shared<translate>(box2, vec3(130, 0, 65));
   world.add(box2);
 
-  // lights
-  auto empty_material = shared_ptr<material>();
-  quad light_quad(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), empty_material);
+  // lights, with the emitter of the world's light quad so shadow rays can take their emission from them
+  quad light_quad(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), light);
   hittable_list lights_list;
   lights_list.add(make_shared<quad>(light_quad));
 
@@ -264,9 +263,8 @@ Scene cornell_smoke() {
   objects.add(make_shared<constant_medium>(box1, 0.01, color(0, 0, 0)));
   objects.add(make_shared<constant_medium>(box2, 0.01, color(1, 1, 1)));
 
-  // lights
-  auto empty_material = shared_ptr<material>();
-  quad light_quad(point3(113, 554, 127), vec3(330, 0, 0), vec3(0, 0, 305), empty_material);
+  // lights, with the emitter of the world's light quad so shadow rays can take their emission from them
+  quad light_quad(point3(113, 554, 127), vec3(330, 0, 0), vec3(0, 0, 305), light);
   hittable_list lights_list;
   lights_list.add(make_shared<quad>(light_quad));
 
@@ -341,10 +339,9 @@ Scene final_scene() {
 
   world.add(make_shared<translate>(make_shared<rotate_y>(make_shared<bvh_node>(boxes2), 15), vec3(-100, 270, 395)));
 
-  // lights
-  auto empty_material = shared_ptr<material>();
+  // lights, with the emitter of the world's light quad so shadow rays can take their emission from them
   hittable_list lights_list;
-  lights_list.add(make_shared<quad>(point3(123, 554, 147), vec3(300, 0, 0), vec3(0, 0, 265), empty_material));
+  lights_list.add(make_shared<quad>(point3(123, 554, 147), vec3(300, 0, 0), vec3(0, 0, 265), light));
 
   Scene scene;
   scene.world = world;
@@ -0,0 +1,116 @@
+#pragma once
+
+// 4-lane SSE/AVX registers behind basic_vec3 in a build with GLIMPSE_SIMD_VEC3 defined (CMake's USE_SIMD_VEC3): x, y,
+// z and a padding lane. Every operation rounds like the scalar code in vec3.h, in the same order, so the switch
+// changes speed and not results.
+#if !defined(__SSE2__) && !defined(_M_X64)
+#error "GLIMPSE_SIMD_VEC3 needs an x86-64 target"
+#endif
+
+#include <immintrin.h>
+
+namespace glimpse::simd {
+
+template <typename T>
+struct lanes4;
+
+// One SSE register
+template <>
+struct lanes4<float> {
+  using type = __m128;
+  static constexpr int alignment = 16;
+
+  static type load(const float* p) { return _mm_load_ps(p); }
+  static void store(float* p, type v) { _mm_store_ps(p, v); }
+  static type broadcast(float t) { return _mm_set1_ps(t); }
+
+  static type add(type a, type b) { return _mm_add_ps(a, b); }
+  static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+  static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+  static type neg(type a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+  static type sqrt(type a) { return _mm_sqrt_ps(a); }
+
+  // (x + y) + z, the padding lane left out
+  static float dot3(type a, type b) {
+    type m = _mm_mul_ps(a, b);
+    type y = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+    type z = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(m, y), z));
+  }
+
+  // a * b.yzx - a.yzx * b is the cross product in zxy order, three shuffles rather than four
+  static type cross3(type a, type b) {
+    type a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    type b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    type c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+  }
+};
+
+#ifdef __AVX2__
+// One AVX register
+template <>
+struct lanes4<double> {
+  using type = __m256d;
+  static constexpr int alignment = 32;
+
+  static type load(const double* p) { return _mm256_load_pd(p); }
+  static void store(double* p, type v) { _mm256_store_pd(p, v); }
+  static type broadcast(double t) { return _mm256_set1_pd(t); }
+
+  static type add(type a, type b) { return _mm256_add_pd(a, b); }
+  static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+  static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+  static type neg(type a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+  static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+
+  static double dot3(type a, type b) {
+    type m = _mm256_mul_pd(a, b);
+    __m128d xy = _mm256_castpd256_pd128(m);
+    __m128d z = _mm256_extractf128_pd(m, 1);
+    return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), z));
+  }
+
+  static type cross3(type a, type b) {
+    type a_yzx = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 0, 2, 1));
+    type b_yzx = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 0, 2, 1));
+    type c = _mm256_sub_pd(_mm256_mul_pd(a, b_yzx), _mm256_mul_pd(a_yzx, b));
+    return _mm256_permute4x64_pd(c, _MM_SHUFFLE(3, 0, 2, 1));
+  }
+};
+#else
+// Two SSE2 registers, (x, y) and (z, padding), without AVX2's shuffles across the halves of a register
+template <>
+struct lanes4<double> {
+  struct type {
+    __m128d xy, zw;
+  };
+  static constexpr int alignment = 16;
+
+  static type load(const double* p) { return {_mm_load_pd(p), _mm_load_pd(p + 2)}; }
+  static void store(double* p, type v) {
+    _mm_store_pd(p, v.xy);
+    _mm_store_pd(p + 2, v.zw);
+  }
+  static type broadcast(double t) { return {_mm_set1_pd(t), _mm_set1_pd(t)}; }
+
+  static type add(type a, type b) { return {_mm_add_pd(a.xy, b.xy), _mm_add_pd(a.zw, b.zw)}; }
+  static type sub(type a, type b) { return {_mm_sub_pd(a.xy, b.xy), _mm_sub_pd(a.zw, b.zw)}; }
+  static type mul(type a, type b) { return {_mm_mul_pd(a.xy, b.xy), _mm_mul_pd(a.zw, b.zw)}; }
+  static type neg(type a) { return {_mm_xor_pd(a.xy, _mm_set1_pd(-0.0)), _mm_xor_pd(a.zw, _mm_set1_pd(-0.0))}; }
+  static type sqrt(type a) { return {_mm_sqrt_pd(a.xy), _mm_sqrt_pd(a.zw)}; }
+
+  static double dot3(type a, type b) {
+    __m128d xy = _mm_mul_pd(a.xy, b.xy);
+    __m128d z = _mm_mul_sd(a.zw, b.zw);
+    return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), z));
+  }
+
+  // (y, z) and (x, padding)
+  static type yzx(type a) { return {_mm_shuffle_pd(a.xy, a.zw, 0b01), _mm_shuffle_pd(a.xy, a.zw, 0b10)}; }
+
+  static type cross3(type a, type b) { return yzx(sub(mul(a, yzx(b)), mul(yzx(a), b))); }
+};
+#endif
+
+}  // namespace glimpse::simd
@@ -12,7 +12,7 @@ constexpr bool USE_FLOAT_PIXELS = false;
 
 image_texture::image_texture(const char *filename) : m_image(std::make_shared<Image>(filename)) {}
 
-color image_texture::value(double u, double v, const vec3 &p) const {
+color image_texture::value(real u, real v, const vec3 &p) const {
   // If we have no texture data, then return solid cyan as a debugging aid.
   // if (m_image == nullptr || m_image->height() <= 0) return color(0, 1, 1);
   if (!m_image || !m_image->is_valid()) return color(0, 1, 1);
@@ -11,16 +11,16 @@ class texture {
  public:
   virtual ~texture() = default;
 
-  virtual color value(double u, double v, const point3 &p) const = 0;
+  virtual color value(real u, real v, const point3 &p) const = 0;
 };
 
 class solid_color : public texture {
  public:
   solid_color(const color &albedo) : albedo(albedo) {}
 
-  solid_color(double red, double green, double blue) : solid_color(color(red, green, blue)) {}
+  solid_color(real red, real green, real blue) : solid_color(color(red, green, blue)) {}
 
-  color value(double u, double v, const point3 &p) const override { return albedo; }
+  color value(real u, real v, const point3 &p) const override { return albedo; }
 
  private:
   color albedo;
@@ -28,13 +28,13 @@ class solid_color : public texture {
 
 class checker_texture : public texture {
  public:
-  checker_texture(double scale, shared_ptr<texture> even, shared_ptr<texture> odd)
+  checker_texture(real scale, shared_ptr<texture> even, shared_ptr<texture> odd)
       : inv_scale(1.0 / scale), even(even), odd(odd) {}
 
-  checker_texture(double scale, const color &c1, const color &c2)
+  checker_texture(real scale, const color &c1, const color &c2)
       : checker_texture(scale, make_shared<solid_color>(c1), make_shared<solid_color>(c2)) {}
 
-  color value(double u, double v, const point3 &p) const override {
+  color value(real u, real v, const point3 &p) const override {
     auto xInteger = int(std::floor(inv_scale * p.x()));
     auto yInteger = int(std::floor(inv_scale * p.y()));
     auto zInteger = int(std::floor(inv_scale * p.z()));
@@ -45,7 +45,7 @@ class checker_texture : public texture {
   }
 
  private:
-  double inv_scale;
+  real inv_scale;
   shared_ptr<texture> even;
   shared_ptr<texture> odd;
 };
@@ -54,7 +54,7 @@ class image_texture : public texture {
  public:
   image_texture(const char *filename);
 
-  color value(double u, double v, const point3 &p) const override;
+  color value(real u, real v, const point3 &p) const override;
 
  private:
   std::shared_ptr<Image> m_image;
@@ -62,12 +62,12 @@ class image_texture : public texture {
 
 class noise_texture : public texture {
  public:
-  noise_texture(double scale, color c = color(.5, .5, .5)) : scale(scale), base_color(c) {}
+  noise_texture(real scale, color c = color(.5, .5, .5)) : scale(scale), base_color(c) {}
 
-  color value(double u, double v, const point3 &p) const override {
+  color value(real u, real v, const point3 &p) const override {
     // return base_color * (1 + std::sin(scale * p.z() + 10 * noise.turb(p, 7)));
 
-    double dynamic_scale = scale * (1.2 * std::sin(1 * math::pi * u) + 0.3 * std::cos(3 * math::pi * v));
+    real dynamic_scale = scale * (1.2 * std::sin(1 * math::pi * u) + 0.3 * std::cos(3 * math::pi * v));
     return base_color * (1 + std::sin(dynamic_scale * p.z() + 10 * noise.turb(p, 7)));
 
     // double combined = scale * (p.x() * u + p.y() * v + p.z());
@@ -79,7 +79,7 @@ class noise_texture : public texture {
 
  private:
   perlin noise;
-  double scale;
+  real scale;
   color base_color;
 };
 
@@ -0,0 +1,86 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#include "common.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace glimpse;
+
+// Binds `thread` to a single logical CPU. Returns false where that isn't supported (macOS, ...).
+static bool pin_to_cpu(std::thread &thread, int cpu) {
+#if defined(_WIN32)
+  return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (cpu % 64)) != 0;
+#elif defined(__linux__)
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+  (void)thread;
+  (void)cpu;
+  return false;
+#endif
+}
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads) {
+  num_threads = std::max(1, num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    m_Threads.emplace_back([this]() { worker_loop(); });
+  }
+
+  if (pin_threads) {
+    const int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    m_Pinned = true;
+    for (int i = 0; i < num_threads; ++i) {
+      m_Pinned = pin_to_cpu(m_Threads[i], i % num_cpus) && m_Pinned;
+    }
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stopping = true;
+  }
+  m_Condition.notify_all();
+
+  for (auto &thread : m_Threads) {
+    thread.join();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  auto future = packaged.get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Tasks.push(std::move(packaged));
+  }
+  m_Condition.notify_one();
+  return future;
+}
+
+void ThreadPool::worker_loop() {
+  Random::init_thread();
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+      // Drain whatever is queued before shutting down, so no future is left dangling.
+      if (m_Stopping && m_Tasks.empty()) return;
+      task = std::move(m_Tasks.front());
+      m_Tasks.pop();
+    }
+    task();
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace glimpse {
+
+// A fixed set of worker threads that live as long as the pool, so renders don't pay for
+// spinning threads up and down every frame.
+class ThreadPool {
+ public:
+  // With `pin_threads`, worker i is bound to logical CPU i (mod the CPU count) where the platform allows it.
+  explicit ThreadPool(int num_threads, bool pin_threads = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Queue a task, the returned future becomes ready once a worker has run it.
+  std::future<void> submit(std::function<void()> task);
+
+  int size() const { return static_cast<int>(m_Threads.size()); }
+
+  // Whether every worker was pinned, false when pinning was not asked for or not supported.
+  bool pinned() const { return m_Pinned; }
+
+ private:
+  void worker_loop();
+
+  std::vector<std::thread> m_Threads;
+  std::queue<std::packaged_task<void()>> m_Tasks;
+  std::mutex m_Mutex;
+  std::condition_variable m_Condition;
+  bool m_Stopping = false;
+  bool m_Pinned = false;
+};
+
+}  // namespace glimpse
@@ -0,0 +1,127 @@
+#include "tile_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace glimpse;
+
+TileScheduler::TileScheduler(int width, int height, int tile_size, int num_workers) {
+  tile_size = std::max(1, tile_size);
+
+  for (int y0 = 0; y0 < height; y0 += tile_size) {
+    for (int x0 = 0; x0 < width; x0 += tile_size) {
+      m_Tiles.push_back(Tile{x0, y0, std::min(x0 + tile_size, width), std::min(y0 + tile_size, height)});
+    }
+  }
+
+  create_queues(num_workers);
+}
+
+TileScheduler::TileScheduler(int width, int height, int tile_size, int num_workers,
+                             const std::vector<Tile> &regions) {
+  tile_size = std::max(1, tile_size);
+
+  // Per grid tile, take the union of the regions row by row, then merge rows with the same spans into one tile.
+  std::vector<std::pair<int, int>> spans, previous;
+  for (int y0 = 0; y0 < height; y0 += tile_size) {
+    for (int x0 = 0; x0 < width; x0 += tile_size) {
+      const Tile cell{x0, y0, std::min(x0 + tile_size, width), std::min(y0 + tile_size, height)};
+
+      previous.clear();
+      for (int y = cell.y0; y < cell.y1; ++y) {
+        spans.clear();
+        for (auto &region : regions) {
+          int begin = std::max(region.x0, cell.x0), end = std::min(region.x1, cell.x1);
+          if (y >= region.y0 && y < region.y1 && begin < end) spans.push_back({begin, end});
+        }
+        std::sort(spans.begin(), spans.end());
+
+        // Union of the overlapping spans
+        size_t merged = 0;
+        for (size_t k = 0; k < spans.size(); ++k) {
+          if (merged > 0 && spans[k].first <= spans[merged - 1].second) {
+            spans[merged - 1].second = std::max(spans[merged - 1].second, spans[k].second);
+          } else {
+            spans[merged++] = spans[k];
+          }
+        }
+        spans.resize(merged);
+
+        if (spans == previous) {
+          // Same coverage as the row above, grow those tiles instead.
+          for (size_t t = m_Tiles.size() - spans.size(); t < m_Tiles.size(); ++t) m_Tiles[t].y1 = y + 1;
+        } else {
+          for (auto &[begin, end] : spans) m_Tiles.push_back(Tile{begin, y, end, y + 1});
+          previous = spans;
+        }
+      }
+    }
+  }
+
+  create_queues(num_workers);
+}
+
+void TileScheduler::create_queues(int num_workers) {
+  num_workers = std::max(1, num_workers);
+  for (int w = 0; w < num_workers; ++w) {
+    m_Queues.push_back(std::make_unique<WorkerQueue>());
+  }
+
+  reset();
+}
+
+void TileScheduler::reset() {
+  const size_t num_workers = m_Queues.size();
+  const size_t num_tiles = m_Tiles.size();
+
+  for (size_t w = 0; w < num_workers; ++w) {
+    // Contiguous runs keep neighbouring tiles on the same worker until someone has to steal.
+    size_t begin = w * num_tiles / num_workers;
+    size_t end = (w + 1) * num_tiles / num_workers;
+
+    std::lock_guard<std::mutex> lock(m_Queues[w]->mutex);
+    m_Queues[w]->tiles.assign(m_Tiles.begin() + begin, m_Tiles.begin() + end);
+  }
+
+  std::lock_guard<std::mutex> lock(m_FinishedMutex);
+  m_Finished.clear();
+}
+
+bool TileScheduler::next(int worker, Tile &tile, bool &stolen) {
+  const int num_workers = static_cast<int>(m_Queues.size());
+
+  {
+    auto &own = *m_Queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tiles.empty()) {
+      tile = own.tiles.front();
+      own.tiles.pop_front();
+      stolen = false;
+      return true;
+    }
+  }
+
+  // Own queue is empty, steal from the far end of someone else's.
+  for (int i = 1; i < num_workers; ++i) {
+    auto &victim = *m_Queues[(worker + i) % num_workers];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tiles.empty()) {
+      tile = victim.tiles.back();
+      victim.tiles.pop_back();
+      stolen = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TileScheduler::finish(const Tile &tile) {
+  std::lock_guard<std::mutex> lock(m_FinishedMutex);
+  m_Finished.push_back(tile);
+}
+
+std::vector<Tile> TileScheduler::take_finished() {
+  std::lock_guard<std::mutex> lock(m_FinishedMutex);
+  return std::exchange(m_Finished, {});
+}
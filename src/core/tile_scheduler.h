@@ -0,0 +1,66 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace glimpse {
+
+// A rectangular block of pixels [x0, x1) x [y0, y1), the unit of work handed to render workers.
+struct Tile {
+  int x0, y0;
+  int x1, y1;
+
+  int width() const { return x1 - x0; }
+  int height() const { return y1 - y0; }
+  int pixel_count() const { return width() * height(); }
+
+  bool operator==(const Tile &) const = default;
+};
+
+// Splits a frame into small tiles and hands them out to a fixed set of workers.
+// Each worker owns a queue seeded with a contiguous run of tiles (so without stealing this degenerates
+// to the old row bands). A worker takes tiles from the front of its own queue, and once that is empty it
+// steals from the back of the other queues, so nobody sits idle while there is work left anywhere.
+class TileScheduler {
+ public:
+  TileScheduler(int width, int height, int tile_size, int num_workers);
+
+  // Only the pixels covered by `regions` (clipped to the frame). Tiles follow the same grid as a full frame and
+  // overlapping regions are merged, so every covered pixel is in exactly one tile.
+  TileScheduler(int width, int height, int tile_size, int num_workers, const std::vector<Tile> &regions);
+
+  // Refill the worker queues with every tile of the frame.
+  void reset();
+
+  // Fetch the next tile for `worker`. Returns false once all queues are drained.
+  // `stolen` is set when the tile came from another worker's queue.
+  bool next(int worker, Tile &tile, bool &stolen);
+
+  // Record that a worker is done writing `tile` for this pass. Safe to call from any worker.
+  void finish(const Tile &tile);
+
+  // Tiles finished since the last call (or reset()). No worker touches them again this pass, so they can be read
+  // while the rest of the pass is still running.
+  std::vector<Tile> take_finished();
+
+  const std::vector<Tile> &tiles() const { return m_Tiles; }
+  int num_workers() const { return static_cast<int>(m_Queues.size()); }
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Tile> tiles;
+  };
+
+  void create_queues(int num_workers);
+
+  std::vector<Tile> m_Tiles;
+  std::vector<std::unique_ptr<WorkerQueue>> m_Queues;
+
+  std::mutex m_FinishedMutex;
+  std::vector<Tile> m_Finished;
+};
+
+}  // namespace glimpse
@@ -1,95 +1,212 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
 #include "common.h"
+#ifdef GLIMPSE_SIMD_VEC3
+#include "simd.h"
+#endif
 
 namespace glimpse {
 
-class vec3 {
+// Three components of scalar type `T`. The renderer works in basic_vec3<real> (vec3, point3 and color), the
+// template lets code in the other precision, like tests checking float against double, use the same vector math.
+// With GLIMPSE_SIMD_VEC3 the components sit in an SSE/AVX register padded to 4 lanes and the arithmetic below runs
+// on whole registers (simd.h), with the same results.
+template <typename T>
+class basic_vec3 {
  public:
-  double e[3];
+  using scalar = T;
+
+#ifdef GLIMPSE_SIMD_VEC3
+  using lanes = simd::lanes4<T>;
+
+  alignas(lanes::alignment) T e[4];  // x, y, z and padding
 
-  vec3() : e{0, 0, 0} {}
-  vec3(double e0, double e1, double e2) : e{e0, e1, e2} {}
+  explicit basic_vec3(typename lanes::type v) { lanes::store(e, v); }
+  typename lanes::type load() const { return lanes::load(e); }
+#else
+  T e[3];
+#endif
 
-  double x() const { return e[0]; }
-  double y() const { return e[1]; }
-  double z() const { return e[2]; }
+  basic_vec3() : e{0, 0, 0} {}
+  basic_vec3(T e0, T e1, T e2) : e{e0, e1, e2} {}
 
-  vec3 operator-() const { return vec3(-e[0], -e[1], -e[2]); }
-  double operator[](int i) const { return e[i]; }
-  double& operator[](int i) { return e[i]; }
+  // From the other precision, rounded to T
+  template <typename U>
+  explicit basic_vec3(const basic_vec3<U>& v)
+      : e{static_cast<T>(v.e[0]), static_cast<T>(v.e[1]), static_cast<T>(v.e[2])} {}
 
-  vec3& operator+=(const vec3& v) {
+  T x() const { return e[0]; }
+  T y() const { return e[1]; }
+  T z() const { return e[2]; }
+
+  basic_vec3 operator-() const {
+#ifdef GLIMPSE_SIMD_VEC3
+    return basic_vec3(lanes::neg(load()));
+#else
+    return basic_vec3(-e[0], -e[1], -e[2]);
+#endif
+  }
+  T operator[](int i) const { return e[i]; }
+  T& operator[](int i) { return e[i]; }
+
+  basic_vec3& operator+=(const basic_vec3& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+    lanes::store(e, lanes::add(load(), v.load()));
+#else
     e[0] += v.e[0];
     e[1] += v.e[1];
     e[2] += v.e[2];
+#endif
     return *this;
   }
 
-  vec3& operator*=(double t) {
+  basic_vec3& operator*=(T t) {
+#ifdef GLIMPSE_SIMD_VEC3
+    lanes::store(e, lanes::mul(load(), lanes::broadcast(t)));
+#else
     e[0] *= t;
     e[1] *= t;
     e[2] *= t;
+#endif
     return *this;
   }
 
-  vec3& operator/=(double t) { return *this *= 1 / t; }
+  basic_vec3& operator/=(T t) { return *this *= 1 / t; }
 
-  bool operator==(const vec3& v) const { return e[0] == v.e[0] && e[1] == v.e[1] && e[2] == v.e[2]; }
+  bool operator==(const basic_vec3& v) const { return e[0] == v.e[0] && e[1] == v.e[1] && e[2] == v.e[2]; }
 
-  bool operator!=(const vec3& v) const { return !(*this == v); }
+  bool operator!=(const basic_vec3& v) const { return !(*this == v); }
 
-  double length() const { return std::sqrt(length_squared()); }
+  T length() const { return std::sqrt(length_squared()); }
 
-  double length_squared() const { return e[0] * e[0] + e[1] * e[1] + e[2] * e[2]; }
+  T length_squared() const {
+#ifdef GLIMPSE_SIMD_VEC3
+    return lanes::dot3(load(), load());
+#else
+    return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+#endif
+  }
 
   bool near_zero() const {
     // Return true if the vector is close to zero in all dimensions.
-    auto s = 1e-8;
+    auto s = T(1e-8);
     return (std::fabs(e[0]) < s) && (std::fabs(e[1]) < s) && (std::fabs(e[2]) < s);
   }
 
-  static vec3 random() { return vec3(random_double(), random_double(), random_double()); }
+  static basic_vec3 random() { return basic_vec3(random_double(), random_double(), random_double()); }
 
-  static vec3 random(double min, double max) {
-    return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+  static basic_vec3 random(double min, double max) {
+    return basic_vec3(random_double(min, max), random_double(min, max), random_double(min, max));
   }
-
-  friend std::ostream& operator<<(std::ostream& out, const vec3& v);
 };
 
 // Define the ostream operator
-inline std::ostream& operator<<(std::ostream& out, const vec3& v) {
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const basic_vec3<T>& v) {
   return out << '(' << v.e[0] << ", " << v.e[1] << ", " << v.e[2] << ')';
 }
 
+using vec3 = basic_vec3<real>;
 // point3 is just an alias for vec3, but useful for geometric clarity in the code.
 using point3 = vec3;
 using color = vec3;
 
 // Vector Utility Functions
+// Scalars are taken as std::type_identity_t<T>, so T comes from the vector alone and a double scalar still scales a
+// float vector.
+
+template <typename T>
+inline basic_vec3<T> operator+(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::add(u.load(), v.load()));
+#else
+  return basic_vec3<T>(u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]);
+#endif
+}
 
-inline vec3 operator+(const vec3& u, const vec3& v) { return vec3(u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]); }
+template <typename T>
+inline basic_vec3<T> operator-(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::sub(u.load(), v.load()));
+#else
+  return basic_vec3<T>(u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]);
+#endif
+}
 
-inline vec3 operator-(const vec3& u, const vec3& v) { return vec3(u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]); }
+template <typename T>
+inline basic_vec3<T> operator*(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::mul(u.load(), v.load()));
+#else
+  return basic_vec3<T>(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]);
+#endif
+}
 
-inline vec3 operator*(const vec3& u, const vec3& v) { return vec3(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]); }
+template <typename T>
+inline basic_vec3<T> operator*(std::type_identity_t<T> t, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::mul(basic_vec3<T>::lanes::broadcast(t), v.load()));
+#else
+  return basic_vec3<T>(t * v.e[0], t * v.e[1], t * v.e[2]);
+#endif
+}
 
-inline vec3 operator*(double t, const vec3& v) { return vec3(t * v.e[0], t * v.e[1], t * v.e[2]); }
+template <typename T>
+inline basic_vec3<T> operator*(const basic_vec3<T>& v, std::type_identity_t<T> t) {
+  return t * v;
+}
 
-inline vec3 operator*(const vec3& v, double t) { return t * v; }
+template <typename T>
+inline basic_vec3<T> operator/(const basic_vec3<T>& v, std::type_identity_t<T> t) {
+  return (1 / t) * v;
+}
 
-inline vec3 operator/(const vec3& v, double t) { return (1 / t) * v; }
+template <typename T>
+inline T dot(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>::lanes::dot3(u.load(), v.load());
+#else
+  return u.e[0] * v.e[0] + u.e[1] * v.e[1] + u.e[2] * v.e[2];
+#endif
+}
 
-inline double dot(const vec3& u, const vec3& v) { return u.e[0] * v.e[0] + u.e[1] * v.e[1] + u.e[2] * v.e[2]; }
+template <typename T>
+inline basic_vec3<T> cross(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::cross3(u.load(), v.load()));
+#else
+  return basic_vec3<T>(u.e[1] * v.e[2] - u.e[2] * v.e[1], u.e[2] * v.e[0] - u.e[0] * v.e[2],
+                       u.e[0] * v.e[1] - u.e[1] * v.e[0]);
+#endif
+}
 
-inline vec3 cross(const vec3& u, const vec3& v) {
-  return vec3(u.e[1] * v.e[2] - u.e[2] * v.e[1], u.e[2] * v.e[0] - u.e[0] * v.e[2], u.e[0] * v.e[1] - u.e[1] * v.e[0]);
+template <typename T>
+inline basic_vec3<T> unit_vector(const basic_vec3<T>& v) {
+  return v / v.length();
 }
 
-inline vec3 unit_vector(const vec3& v) { return v / v.length(); }
+template <typename T>
+inline basic_vec3<T> sqrt(basic_vec3<T> v) {
+#ifdef GLIMPSE_SIMD_VEC3
+  return basic_vec3<T>(basic_vec3<T>::lanes::sqrt(v.load()));
+#else
+  return basic_vec3<T>(std::sqrt(v.e[0]), std::sqrt(v.e[1]), std::sqrt(v.e[2]));
+#endif
+}
 
-inline vec3 sqrt(vec3 v) { return vec3(sqrt(v.e[0]), sqrt(v.e[1]), sqrt(v.e[2])); }
+// Start of the interval (t_min) to trace a ray leaving the surface at `origin` over, so it does not find that
+// surface again. 0.001, or more where the rounding error of a hit point, which grows with its distance from the
+// scene origin, could put it further from the surface: only reached in float, see real.
+template <typename T>
+inline T self_intersection_epsilon(const basic_vec3<T>& origin) {
+  constexpr T rounding = 64 * std::numeric_limits<T>::epsilon();  // of a hit point, relative to its coordinates
+  T magnitude = std::max({std::fabs(origin.x()), std::fabs(origin.y()), std::fabs(origin.z())});
+  return std::max(T(0.001), magnitude * rounding);
+}
 
 inline vec3 random_unit_vector() {
   while (true) {
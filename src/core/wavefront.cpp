@@ -0,0 +1,324 @@
+#include "wavefront.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <typeinfo>
+#include <utility>
+
+#include "pdf.h"
+
+namespace glimpse {
+
+void RayQueue::clear() {
+  for (auto *field : {&origin_x, &origin_y, &origin_z, &direction_x, &direction_y, &direction_z, &time, &throughput_r,
+                      &throughput_g, &throughput_b, &expected_r, &expected_g, &expected_b, &bsdf_pdf}) {
+    field->clear();
+  }
+  path.clear();
+}
+
+void RayQueue::push(int path_index, const ray &r, const color &throughput, const color &expected, double pdf) {
+  origin_x.push_back(r.origin().x());
+  origin_y.push_back(r.origin().y());
+  origin_z.push_back(r.origin().z());
+  direction_x.push_back(r.direction().x());
+  direction_y.push_back(r.direction().y());
+  direction_z.push_back(r.direction().z());
+  time.push_back(r.time());
+  throughput_r.push_back(throughput.x());
+  throughput_g.push_back(throughput.y());
+  throughput_b.push_back(throughput.z());
+  expected_r.push_back(expected.x());
+  expected_g.push_back(expected.y());
+  expected_b.push_back(expected.z());
+  bsdf_pdf.push_back(pdf);
+  path.push_back(path_index);
+}
+
+ray RayQueue::get_ray(size_t k) const {
+  return ray(point3(origin_x[k], origin_y[k], origin_z[k]), vec3(direction_x[k], direction_y[k], direction_z[k]),
+             time[k]);
+}
+
+void HitQueue::clear() {
+  for (auto *field : {&t, &u, &v, &p_x, &p_y, &p_z, &normal_x, &normal_y, &normal_z, &error}) field->clear();
+  ray.clear();
+  front_face.clear();
+  mat.clear();
+}
+
+void HitQueue::push(int ray_index, const hit_record &rec) {
+  ray.push_back(ray_index);
+  t.push_back(rec.t);
+  u.push_back(rec.u);
+  v.push_back(rec.v);
+  p_x.push_back(rec.p.x());
+  p_y.push_back(rec.p.y());
+  p_z.push_back(rec.p.z());
+  normal_x.push_back(rec.normal.x());
+  normal_y.push_back(rec.normal.y());
+  normal_z.push_back(rec.normal.z());
+  error.push_back(rec.error);
+  front_face.push_back(rec.front_face);
+  mat.push_back(rec.mat.get());
+}
+
+hit_record HitQueue::get_record(size_t k) const {
+  hit_record rec;
+  rec.p = point3(p_x[k], p_y[k], p_z[k]);
+  rec.normal = vec3(normal_x[k], normal_y[k], normal_z[k]);
+  rec.t = t[k];
+  rec.u = u[k];
+  rec.v = v[k];
+  rec.error = error[k];
+  rec.front_face = front_face[k] != 0;
+  return rec;
+}
+
+void Wavefront::begin() {
+  m_Rays.clear();
+  m_Radiance.clear();
+  m_RaysTraced.clear();
+  m_Streams.clear();
+}
+
+int Wavefront::add_path(const ray &r) {
+  int path = size();
+  m_Radiance.emplace_back(0, 0, 0);
+  m_RaysTraced.push_back(0);
+  m_Streams.push_back(Random::stream());
+  m_Rays.push(path, r, color(1, 1, 1), color(1, 1, 1));
+  return path;
+}
+
+void Wavefront::trace(const hittable &world, const color &background, const hittable &lights, bool has_lights,
+                      int max_depth, const RenderSettings &settings) {
+  const auto &roulette = settings.roulette;
+  // Bounce 0 is the camera ray. As in ray_color(), the hits of the last bounce are still shaded for their
+  // emission, the rays they scatter are dropped.
+  const aabb bounds = settings.sort_rays ? world.bounding_box() : aabb();
+  // A medium draws its scattering distance inside hit(), which a packet can only feed from one stream. Each path
+  // keeps its own numbers by going one ray at a time through scenes with volumes.
+  const bool packets = settings.packet_camera_rays && !world.has_volume();
+  for (int bounce = 0; bounce <= max_depth && m_Rays.size() > 0; ++bounce) {
+    // Camera rays are coherent already
+    if (settings.sort_rays && bounce > 0) {
+      sort_rays(bounds);
+    } else {
+      m_RayOrder.resize(m_Rays.size());
+      std::iota(m_RayOrder.begin(), m_RayOrder.end(), 0);
+    }
+    if (packets && bounce == 0) {
+      intersect_packets(world, background);
+    } else {
+      intersect(world, background);
+    }
+    if (settings.sort_by_material) {
+      sort_hits();
+    } else {
+      m_Order.resize(m_Hits.size());
+      std::iota(m_Order.begin(), m_Order.end(), 0);
+    }
+
+    const bool play_roulette = roulette.enabled && bounce < max_depth && bounce + 1 >= roulette.start_depth;
+    if (has_lights) {
+      shade<true>(world, lights, has_lights, settings, play_roulette, bounce == max_depth);
+    } else {
+      shade<false>(world, lights, has_lights, settings, play_roulette, bounce == max_depth);
+    }
+    std::swap(m_Rays, m_NextRays);
+  }
+  m_Rays.clear();
+}
+
+// Every other bit of the low 10 bits of `bits` spread two bits apart, for a 3D Morton code.
+static uint64_t spread_bits(uint64_t bits) {
+  bits &= 0x3ff;
+  bits = (bits | (bits << 16)) & 0x30000ff;
+  bits = (bits | (bits << 8)) & 0x300f00f;
+  bits = (bits | (bits << 4)) & 0x30c30c3;
+  bits = (bits | (bits << 2)) & 0x9249249;
+  return bits;
+}
+
+// Cell of `value` along an axis of the bounds, 10 bits.
+static uint64_t grid_cell(double value, const interval &axis) {
+  double t = axis.size() > 0 ? (value - axis.min) / axis.size() : 0.0;
+  return static_cast<uint64_t>(std::clamp(t, 0.0, 1.0) * 1023.0);
+}
+
+void Wavefront::sort_rays(const aabb &bounds) {
+  // 3 octant bits above a 30-bit Morton code leave 31 bits for the ray index
+  const size_t count = m_Rays.size();
+  m_RayKeys.resize(count);
+  for (size_t k = 0; k < count; ++k) {
+    uint64_t octant = (m_Rays.direction_x[k] < 0 ? 1 : 0) | (m_Rays.direction_y[k] < 0 ? 2 : 0) |
+                      (m_Rays.direction_z[k] < 0 ? 4 : 0);
+    uint64_t morton = spread_bits(grid_cell(m_Rays.origin_x[k], bounds.x)) |
+                      (spread_bits(grid_cell(m_Rays.origin_y[k], bounds.y)) << 1) |
+                      (spread_bits(grid_cell(m_Rays.origin_z[k], bounds.z)) << 2);
+    m_RayKeys[k] = (((octant << 30) | morton) << 31) | k;
+  }
+  std::sort(m_RayKeys.begin(), m_RayKeys.end());
+
+  m_RayOrder.resize(count);
+  for (size_t k = 0; k < count; ++k) m_RayOrder[k] = static_cast<int>(m_RayKeys[k] & 0x7fffffff);
+}
+
+void Wavefront::intersect(const hittable &world, const color &background) {
+  m_Hits.clear();
+
+  hit_record rec;
+  for (int k : m_RayOrder) {
+    const int path = m_Rays.path[k];
+    m_RaysTraced[path]++;
+
+    // Start past the surface the ray leaves to avoid self-intersections. Volumes draw their scattering distance.
+    const ray r = m_Rays.get_ray(k);
+    Random::set_stream(m_Streams[path]);
+    const bool hit = world.hit(r, interval(self_intersection_epsilon(r.origin()), math::infinity), rec);
+    m_Streams[path] = Random::stream();
+    if (hit) {
+      m_Hits.push(k, rec);
+    } else {
+      m_Radiance[path] += m_Rays.get_throughput(k) * background;
+    }
+  }
+}
+
+void Wavefront::intersect_packets(const hittable &world, const color &background) {
+  m_Hits.clear();
+
+  hit_record recs[RayPacket::width];
+  real t_max[RayPacket::width];
+  for (size_t first = 0; first < m_RayOrder.size(); first += RayPacket::width) {
+    const size_t count = std::min<size_t>(RayPacket::width, m_RayOrder.size() - first);
+    m_Packet.clear();
+    // Start past the surface the rays leave to avoid self-intersections, the packet shares one t_min
+    real t_min = 0;
+    for (size_t lane = 0; lane < count; ++lane) {
+      const ray r = m_Rays.get_ray(m_RayOrder[first + lane]);
+      t_min = std::max(t_min, self_intersection_epsilon(r.origin()));
+      m_Packet.push(r);
+    }
+    std::fill(std::begin(t_max), std::end(t_max), math::infinity);
+
+    // No volumes here (see trace()), so nothing on the way draws a random number
+    const int hits = world.hit_packet(m_Packet, m_Packet.mask(), t_min, t_max, recs);
+    for (size_t lane = 0; lane < count; ++lane) {
+      const int k = m_RayOrder[first + lane];
+      const int path = m_Rays.path[k];
+      m_RaysTraced[path]++;
+      if (hits >> lane & 1) {
+        m_Hits.push(k, recs[lane]);
+      } else {
+        m_Radiance[path] += m_Rays.get_throughput(k) * background;
+      }
+    }
+  }
+}
+
+void Wavefront::sort_hits() {
+  // Counting sort on the material type. Scenes have a handful of material types, so a linear lookup is enough.
+  m_HitTypes.resize(m_Hits.size());
+  m_TypeCounts.clear();
+  for (size_t k = 0; k < m_Hits.size(); ++k) {
+    const std::type_info *type = &typeid(*m_Hits.mat[k]);
+    size_t bucket = 0;
+    while (bucket < m_Types.size() && *m_Types[bucket] != *type) ++bucket;
+    if (bucket == m_Types.size()) m_Types.push_back(type);
+    if (bucket >= m_TypeCounts.size()) m_TypeCounts.resize(bucket + 1, 0);
+    m_TypeCounts[bucket]++;
+    m_HitTypes[k] = static_cast<int>(bucket);
+  }
+
+  int offset = 0;
+  for (auto &count : m_TypeCounts) offset += std::exchange(count, offset);  // now the start of each bucket
+
+  m_Order.resize(m_Hits.size());
+  for (size_t k = 0; k < m_Hits.size(); ++k) m_Order[m_TypeCounts[m_HitTypes[k]]++] = static_cast<int>(k);
+
+  // Then within each type by instance, which owns its texture. Stable, so each instance's hits stay in ray order.
+  auto by_instance = [this](int a, int b) { return std::less<const material *>()(m_Hits.mat[a], m_Hits.mat[b]); };
+  int start = 0;
+  for (int end : m_TypeCounts) {  // now the end of each bucket
+    std::stable_sort(m_Order.begin() + start, m_Order.begin() + end, by_instance);
+    start = end;
+  }
+}
+
+template <bool Lights>
+void Wavefront::shade(const hittable &world, const hittable &lights, bool has_lights, const RenderSettings &settings,
+                      bool play_roulette, bool last_bounce) {
+  const auto &roulette = settings.roulette;
+  const auto &direct = settings.direct_lighting;
+  const bool lit = Lights && has_lights;
+  const bool next_event = direct.next_event_estimation && lit;
+  m_NextRays.clear();
+
+  for (int h : m_Order) {
+    const int k = m_Hits.ray[h];
+    const int path = m_Rays.path[k];
+    const ray r_in = m_Rays.get_ray(k);
+    const hit_record rec = m_Hits.get_record(h);
+    Random::set_stream(m_Streams[path]);
+    const material *mat = m_Hits.mat[h];
+    color throughput = m_Rays.get_throughput(k);
+
+    color emitted = mat->emitted(r_in, rec, rec.u, rec.v, rec.p);
+    if (Lights && m_Rays.bsdf_pdf[k] > 0 && emitted.length_squared() > 0) {
+      double light_pdf = lights.pdf_value(r_in.origin(), r_in.direction());
+      emitted = emitted * mis_weight(direct.heuristic, m_Rays.bsdf_pdf[k], light_pdf);
+    }
+    m_Radiance[path] += throughput * emitted;
+    scatter_record srec;
+    if (!mat->scatter(r_in, rec, srec)) continue;
+
+    ray scattered;
+    color expected;
+    double bsdf_pdf = 0;
+    if (srec.skip_pdf) {
+      throughput = throughput * srec.attenuation;
+      expected = throughput;
+      scattered = srec.skip_pdf_ray;
+    } else {
+      double pdf_value;
+      if (next_event) {
+        // Shadow rays are traced right here rather than queued for a stage of their own
+        if (!last_bounce) {
+          m_Radiance[path] += throughput * sample_direct_light(r_in, rec, *mat, srec, world, lights, direct.heuristic,
+                                                               m_RaysTraced[path]);
+        }
+        scattered = rec.spawn_ray(srec.pdf_ptr->generate(), r_in.time());
+        pdf_value = srec.pdf_ptr->value(scattered.direction());
+        bsdf_pdf = pdf_value;
+      } else if (lit) {
+        auto light_ptr = make_shared<hittable_pdf>(lights, rec.p);
+        mixture_pdf mixed_pdf(light_ptr, srec.pdf_ptr);
+        scattered = rec.spawn_ray(mixed_pdf.generate(), r_in.time());
+        pdf_value = mixed_pdf.value(scattered.direction());
+      } else {
+        scattered = rec.spawn_ray(srec.pdf_ptr->generate(), r_in.time());
+        pdf_value = srec.pdf_ptr->value(scattered.direction());
+      }
+
+      double scattering_pdf = mat->scattering_pdf(r_in, rec, scattered);
+      expected = throughput * srec.attenuation;
+      throughput = throughput * srec.attenuation * scattering_pdf / pdf_value;
+    }
+
+    if (play_roulette) {
+      double survival = std::min<double>(roulette.max_survival, std::max({expected.x(), expected.y(), expected.z()}));
+      if (random_double() >= survival) continue;
+      throughput = throughput / survival;
+      expected = expected / survival;
+    }
+    m_Streams[path] = Random::stream();
+    m_NextRays.push(path, scattered, throughput, expected, bsdf_pdf);
+  }
+}
+
+}  // namespace glimpse
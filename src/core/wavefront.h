@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+#include "hittables/hittable.h"
+#include "material.h"
+#include "ray_packet.h"
+#include "render.h"
+
+namespace glimpse {
+
+// Rays waiting to be intersected, one entry per live path, stored as structure of arrays.
+struct RayQueue {
+  std::vector<real> origin_x, origin_y, origin_z;
+  std::vector<real> direction_x, direction_y, direction_z;
+  std::vector<real> time;
+  std::vector<real> throughput_r, throughput_g, throughput_b;
+  std::vector<real> expected_r, expected_g, expected_b;  // throughput the roulette looks at, see ray_color()
+  std::vector<real> bsdf_pdf;                             // MIS weight of emission reached, see ray_color()
+  std::vector<int> path;                                    // path of the wave this ray continues
+
+  size_t size() const { return path.size(); }
+  void clear();
+  void push(int path_index, const ray &r, const color &throughput, const color &expected, double pdf = 0);
+
+  ray get_ray(size_t k) const;
+  color get_throughput(size_t k) const { return color(throughput_r[k], throughput_g[k], throughput_b[k]); }
+  color get_expected(size_t k) const { return color(expected_r[k], expected_g[k], expected_b[k]); }
+};
+
+// Rays of a RayQueue that hit something, with what shading needs to know about the hit.
+struct HitQueue {
+  std::vector<int> ray;  // index into the RayQueue
+  std::vector<real> t, u, v;
+  std::vector<real> p_x, p_y, p_z;
+  std::vector<real> normal_x, normal_y, normal_z;
+  std::vector<real> error;  // hit_record::error, how far spawned rays step off the surface
+  std::vector<unsigned char> front_face;
+  std::vector<const material *> mat;
+
+  size_t size() const { return ray.size(); }
+  void clear();
+  void push(int ray_index, const hit_record &rec);
+
+  hit_record get_record(size_t k) const;  // without hit_record::mat, materials never read it
+};
+
+// Wavefront (stream) path tracing. Instead of following one path to its end before starting the next, as
+// ray_color() does, a whole batch of paths (a wave) advances one stage at a time: intersect every ray, then shade
+// every hit, which emits the rays of the next bounce. Each stage streams through its queues, so the same code and
+// data stay hot across the batch. Same estimator as ray_color(). Each path carries on the random stream its camera
+// ray was drawn from, so the wave size and the sorting do not change its numbers; the two engines draw them in a
+// different order though, and agree statistically rather than sample for sample.
+class Wavefront {
+ public:
+  // Empties the wave, keeping the queues' memory.
+  void begin();
+
+  // Adds a path starting with camera ray `r`, continuing this thread's current random stream, and returns its index
+  // in the wave.
+  int add_path(const ray &r);
+
+  // Traces every path of the wave to its end, with the roulette, direct lighting, sorting and packets of
+  // `settings`.
+  void trace(const hittable &world, const color &background, const hittable &lights, bool has_lights,
+             int max_depth, const RenderSettings &settings);
+
+  int size() const { return static_cast<int>(m_Radiance.size()); }
+  const color &radiance(int path) const { return m_Radiance[path]; }
+  int rays_traced(int path) const { return m_RaysTraced[path]; }  // camera ray and every bounce
+
+ private:
+  // Fills m_RayOrder with the rays ordered by direction octant, then by the Morton code of their origin within
+  // `bounds`, so rays traced one after the other tend to walk the same BVH nodes.
+  void sort_rays(const aabb &bounds);
+  // Misses pick up the background, hits go to m_Hits. Rays in m_RayOrder.
+  void intersect(const hittable &world, const color &background);
+  // intersect() in packets of RayPacket::width consecutive rays, for the coherent camera rays of scenes without
+  // volumes.
+  void intersect_packets(const hittable &world, const color &background);
+  // Fills m_Order with the hits grouped by material type, then by material instance.
+  void sort_hits();
+  // Adds emission and queues the next bounce of every hit that scatters into m_NextRays, going through the
+  // hits in m_Order. `play_roulette` when that bounce is past RussianRoulette::start_depth, `last_bounce` when
+  // it will not be traced. Light sampling is compiled out when `Lights` is false, trace() picks the variant.
+  template <bool Lights>
+  void shade(const hittable &world, const hittable &lights, bool has_lights, const RenderSettings &settings,
+             bool play_roulette, bool last_bounce);
+
+  RayQueue m_Rays;
+  RayQueue m_NextRays;
+  HitQueue m_Hits;
+  RayPacket m_Packet;
+  std::vector<const std::type_info *> m_Types;  // material types seen so far, in bucket order
+  std::vector<int> m_TypeCounts;
+  std::vector<int> m_HitTypes;
+  std::vector<int> m_Order;  // order the hits are shaded in
+  std::vector<uint64_t> m_RayKeys;  // sort key in the high bits, ray index in the low ones
+  std::vector<int> m_RayOrder;      // order the rays are intersected in
+  std::vector<color> m_Radiance;
+  std::vector<int> m_RaysTraced;
+  std::vector<Random::Stream> m_Streams;  // random stream of each path, switched to for its intersection and shading
+};
+
+}  // namespace glimpse
@@ -17,29 +17,52 @@ struct RayTracer {
   enum Status { IDLE, RENDERING, DONE };
   std::atomic<Status> status{IDLE};
   std::optional<std::future<void>> trace_future{};
-  std::atomic<int> progress{0};
-
-  std::shared_ptr<Renderer> renderer;
+  RenderProgress progress;
+
+  // Keeps the worker pool, BVH and film alive across renders.
+  RenderSession session;
+  RenderSettings settings{.progressive = true, .resolve_interval = 0.1};
+  CancelToken cancel_token;  // of the render in flight
+  bool scene_dirty = true;
+  // What the session last rendered with. Anything else restarts its film, a render with nothing changed adds to it.
+  std::optional<camera> applied_camera;
+  std::optional<color> applied_background;
+  std::optional<RenderSettings> applied_settings;
 
   Logger& logger;
   RayTracer(Logger& logger) : logger(logger) {}
 
   void renderSceneAsync() {
-    // check if we are already rendering, if yes, then lets do nothing for now.
-    if (renderer.get() != nullptr) {
-      return;
+    // A render is already in flight, cancel it so the new one starts from the latest camera right away.
+    if (trace_future.has_value()) {
+      cancel_token.cancel();
+      trace_future->wait();
+      trace_future.reset();
     }
 
-    renderer = std::make_shared<Renderer>();
-    trace_future = std::async(std::launch::async, [&]() {
-      image.clear();
-      scene.cam.initialize();
+    scene.cam.initialize();
+    if (scene_dirty) {
+      session.set_scene(scene);
+      scene_dirty = false;
+    } else {
+      if (applied_camera != scene.cam) session.update_camera(scene.cam);
+      if (applied_background != scene.background) session.update_background(scene.background);
+    }
+    if (applied_settings != settings) session.update_settings(settings);
+    applied_camera = scene.cam;
+    applied_background = scene.background;
+    applied_settings = settings;
+
+    progress.start(0);
+    status = RENDERING;
+    cancel_token = CancelToken{};
+    trace_future = std::async(std::launch::async, [&, cancel = cancel_token]() {
+      Random::init_thread();
       logger.log("Rendering... ", scene.cam.image_width, "x", scene.cam.image_height, " with ",
                  scene.cam.samples_per_pixel, " samples per pixel");
       auto startTime = std::chrono::high_resolution_clock::now();
 
-      status = RENDERING;
-      renderer->render_scene(scene, image, &progress);
+      session.render(image, &progress, cancel);
       status = DONE;
 
       auto endTime = std::chrono::high_resolution_clock::now();
@@ -50,9 +73,15 @@ struct RayTracer {
   }
 
   void reset() {
+    // Progressive renders never finish on their own, stop the one in flight before waiting on it.
+    if (trace_future.has_value()) {
+      cancel_token.cancel();
+      trace_future->wait();
+      trace_future.reset();
+    }
+    cancel_token = CancelToken{};
     status = IDLE;
-    progress = 0;
-    renderer.reset();
+    progress.start(0);
   }
 
   void setupScene(GLResources& GLResources, int current_scene, float lookFrom[3], float lookAt[3]) {
@@ -64,6 +93,7 @@ struct RayTracer {
 
     logger.log("Setting up scene ... ", current_scene, " ", Scene::SceneNames[current_scene]);
     scene = Scene::SceneMap[Scene::SceneNames[current_scene]]();
+    scene_dirty = true;
 
     GLResources.renderWidth = scene.cam.image_width;
     GLResources.renderHeight = static_cast<int>(scene.cam.image_width / scene.cam.aspect_ratio);
@@ -82,9 +112,7 @@ struct RayTracer {
 
   void stopRendering() {
     if (trace_future.has_value()) {
-      Renderer::stop_rendering = true;
-      // trace_future->wait();
-      // trace_future.reset();
+      cancel_token.cancel();
     }
   }
 };
@@ -7,6 +7,7 @@
 void UIRenderer::cameraUI(RayTracer& raytracer, GLResources& gl_res) {
   // Render parameters
   ImGui::Checkbox("Uncap SPP", &raytracer.scene.cam.uncapped_spp);
+  ImGui::Checkbox("Progressive", &raytracer.settings.progressive);
   if (ImGui::SliderInt("Samples per Pixel", &raytracer.scene.cam.samples_per_pixel, 1, 1000)) {
     maybeRenderOnParamChange(raytracer);
   }
@@ -57,7 +58,7 @@ void UIRenderer::renderControl(RayTracer& raytracer, GLResources& gl_res) {
   if (ImGui::Button("Save Image")) {
     auto now = std::chrono::system_clock::now();
     auto now_time = std::chrono::system_clock::to_time_t(now);
-    auto spp = raytracer.scene.cam.uncapped_spp ? raytracer.renderer->film.get_average_sample_count()
+    auto spp = raytracer.scene.cam.uncapped_spp ? raytracer.session.film().get_average_sample_count()
                                                 : raytracer.scene.cam.samples_per_pixel;
 
     // Ensure the results directory exists
@@ -77,18 +78,17 @@ void UIRenderer::renderControl(RayTracer& raytracer, GLResources& gl_res) {
   }
 
   if (raytracer.status == RayTracer::RENDERING) {
+    const auto progress = raytracer.progress.snapshot();
+    const double pixels = double(gl_res.renderWidth) * gl_res.renderHeight;
     if (raytracer.scene.cam.uncapped_spp) {
-      // TODO: Implement this, add more stats
-      auto avg_spp = raytracer.renderer->film.get_average_sample_count();
-      ImGui::Text("Average SPP ... %d", avg_spp);
+      ImGui::Text("Average SPP ... %.1f (%.1f M rays, %llu tiles)", progress.samples / pixels, progress.rays / 1e6,
+                  static_cast<unsigned long long>(progress.work_units));
       ImGui::ProgressBar(-1.0f * (float)ImGui::GetTime(), ImVec2(0.0f, 0.0f), "Progress..");
     } else {
-      int totalPixels = gl_res.renderWidth * gl_res.renderHeight * raytracer.scene.cam.samples_per_pixel;
-      int samples_done = raytracer.progress.load();
-      ImGui::Text("Rendering...%d/%d", samples_done / (gl_res.renderWidth * gl_res.renderHeight),
-                  raytracer.scene.cam.samples_per_pixel);
-      float progress = float(samples_done) / float(totalPixels);
-      ImGui::ProgressBar(progress, ImVec2(-1, 0), "Progress");
+      const double total_samples = pixels * raytracer.scene.cam.samples_per_pixel;
+      ImGui::Text("Rendering...%.0f/%d (%.1f M rays)", progress.samples / pixels,
+                  raytracer.scene.cam.samples_per_pixel, progress.rays / 1e6);
+      ImGui::ProgressBar(float(progress.samples / total_samples), ImVec2(-1, 0), "Progress");
     }
 
     // TODO: Should we conmtrol how frequent this happens?
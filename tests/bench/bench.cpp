@@ -0,0 +1,148 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+CacheMissCounter::CacheMissCounter() {
+#ifdef __linux__
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.inherit = 1;  // count the render workers too
+  m_Fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter() {
+#ifdef __linux__
+  if (m_Fd >= 0) close(m_Fd);
+#endif
+}
+
+void CacheMissCounter::start() {
+#ifdef __linux__
+  if (m_Fd < 0) return;
+  ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+  ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+uint64_t CacheMissCounter::stop() {
+  uint64_t count = 0;
+#ifdef __linux__
+  if (m_Fd < 0) return 0;
+  ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+  if (read(m_Fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+  return count;
+}
+
+namespace {
+std::ostringstream null_stream;
+}
+
+ConvergenceTiming time_to_error(const glimpse::Scene &scene, const glimpse::hittable &world,
+                                const glimpse::RenderSettings &settings, double error_target, int repeat) {
+  using namespace glimpse;
+  ConvergenceTiming timing;
+  Image image(scene.cam.image_width, scene.cam.image_height);
+  for (int run = 0; run < std::max(1, repeat); ++run) {
+    QuietCout quiet;
+    Random::set_seed(0);
+
+    Renderer renderer;
+    RenderProgress progress;
+    renderer.settings = settings;
+    renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+    auto start = std::chrono::steady_clock::now();
+    renderer.render(scene, world, image, &progress);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (run == 0 || seconds < timing.seconds) {
+      timing.seconds = seconds;
+      timing.totals = progress.snapshot();
+      timing.relative_error = renderer.frame_stats.relative_error;
+    }
+
+    Renderer converging;
+    converging.settings = settings;
+    converging.settings.error_target = error_target;
+    converging.settings.max_spp = 4096;
+    converging.film.initialize(scene.cam.image_width, scene.cam.image_height);
+    converging.render(scene, world, image);
+    if (run == 0 || converging.frame_stats.seconds < timing.error_seconds) {
+      timing.error_seconds = converging.frame_stats.seconds;
+      timing.error_spp = converging.frame_stats.average_spp();
+    }
+  }
+  return timing;
+}
+
+QuietCout::QuietCout() : m_Saved(std::cout.rdbuf(null_stream.rdbuf())) {}
+
+QuietCout::~QuietCout() {
+  std::cout.rdbuf(m_Saved);
+  null_stream.str({});
+}
+
+// Usage: Glimpse_bench <benchmark> [--width N] [--spp N] [--repeat N] [--scene NAME]
+// Build with CMAKE_BUILD_TYPE=Release and run from the repository root (scenes load textures from ./res).
+int main(int argc, char **argv) {
+  const std::map<std::string, std::function<void(const BenchOptions &)>> benchmarks = {
+      {"features", features_bench},
+      {"nee", nee_bench},
+      {"occlusion", occlusion_bench},
+      {"packet", packet_bench},
+      {"random", random_bench},
+      {"roulette", roulette_bench},
+      {"throughput", throughput_bench},
+      {"traversal", traversal_bench},
+      {"vec3", vec3_bench},
+  };
+
+  BenchOptions options;
+  std::string name;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--width" && i + 1 < argc) {
+      options.width = std::stoi(argv[++i]);
+    } else if (arg == "--spp" && i + 1 < argc) {
+      options.spp = std::stoi(argv[++i]);
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      options.repeat = std::stoi(argv[++i]);
+    } else if (arg == "--scene" && i + 1 < argc) {
+      options.scene = argv[++i];
+    } else if (benchmarks.count(arg)) {
+      name = arg;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+    }
+  }
+
+  if (name.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " <benchmark> [--width N] [--spp N] [--repeat N] [--scene NAME]\nBenchmarks:";
+    for (auto &[benchmark, run] : benchmarks) std::cerr << " " << benchmark;
+    std::cerr << std::endl;
+    return 1;
+  }
+
+  benchmarks.at(name)(options);
+  return 0;
+}
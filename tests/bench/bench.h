@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "core/render.h"
+
+// Shared knobs for every benchmark, see bench.cpp for the command line.
+struct BenchOptions {
+  int width = 200;    // image width, the scene's aspect ratio is kept
+  int spp = 4;        // samples per pixel
+  int repeat = 3;     // runs per configuration, the fastest one is reported
+  std::string scene;  // only this scene, empty runs the benchmark's own list
+
+  bool wants(const std::string &name) const { return scene.empty() || scene == name; }
+};
+
+// Hardware cache-miss counter for this process and every thread started after it is opened.
+// Only available on Linux with access to the PMU, otherwise `available()` is false and reads return 0.
+class CacheMissCounter {
+ public:
+  CacheMissCounter();
+  ~CacheMissCounter();
+
+  CacheMissCounter(const CacheMissCounter &) = delete;
+  CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+
+  bool available() const { return m_Fd >= 0; }
+  void start();
+  uint64_t stop();
+
+ private:
+  int m_Fd = -1;
+};
+
+// Mutes std::cout for its lifetime, the renderer reports every pass.
+class QuietCout {
+ public:
+  QuietCout();
+  ~QuietCout();
+
+ private:
+  std::streambuf *m_Saved;
+};
+
+// Best of `repeat` renders of `scene` at its samples per pixel with `settings`, then best of `repeat` renders to
+// bring the frame's mean relative error down to `error_target` (RenderSettings::error_target, up to 4096 spp).
+// Unseeded, see throughput_bench().
+struct ConvergenceTiming {
+  double seconds = 0;  // fastest render at the scene's spp, and what it counted and reached
+  glimpse::ProgressSnapshot totals;
+  double relative_error = 0;
+  double error_seconds = 0;  // fastest render to the error target, and its average spp
+  double error_spp = 0;
+};
+ConvergenceTiming time_to_error(const glimpse::Scene &scene, const glimpse::hittable &world,
+                                const glimpse::RenderSettings &settings, double error_target, int repeat);
+
+void features_bench(const BenchOptions &options);
+void nee_bench(const BenchOptions &options);
+void occlusion_bench(const BenchOptions &options);
+void packet_bench(const BenchOptions &options);
+void random_bench(const BenchOptions &options);
+void roulette_bench(const BenchOptions &options);
+void throughput_bench(const BenchOptions &options);
+void traversal_bench(const BenchOptions &options);
+void vec3_bench(const BenchOptions &options);
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Samples/s of the generic sample loop against the one compiled for the scene's SceneFeatures, with each engine.
+// Scenes from none of the features to all of them; quads and two_diffuse_spheres are cheap enough per sample for
+// the camera ray and the per-bounce checks to show.
+void features_bench(const BenchOptions &options) {
+  std::cout << "scene               | features                      | engine     | generic (M/s) | specialized (M/s)"
+               " | speedup\n";
+
+  for (auto name : {"two_diffuse_spheres", "quads", "random_scene", "cornell_box", "cornell_smoke", "final_scene"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.samples_per_pixel = options.spp;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+    Image image(scene.cam.image_width, scene.cam.image_height);
+
+    for (auto engine : {RenderEngine::Megakernel, RenderEngine::Wavefront}) {
+      // The two variants take turns within each run, see throughput_bench()
+      double best_seconds[2] = {0, 0};
+      ProgressSnapshot totals[2];
+      for (int run = 0; run < std::max(1, options.repeat); ++run) {
+        for (int specialize = 0; specialize < 2; ++specialize) {
+          Renderer renderer;
+          RenderProgress progress;
+          renderer.settings.engine = engine;
+          renderer.settings.specialize = specialize == 1;
+          renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+
+          // Unseeded, see throughput_bench()
+          Random::set_seed(0);
+          auto start = std::chrono::steady_clock::now();
+          {
+            QuietCout quiet;
+            renderer.render(scene, world, image, &progress);
+          }
+          auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+          if (run == 0 || seconds < best_seconds[specialize]) best_seconds[specialize] = seconds;
+          totals[specialize] = progress.snapshot();
+        }
+      }
+
+      const double generic = totals[0].samples / best_seconds[0] / 1e6;
+      const double specialized = totals[1].samples / best_seconds[1] / 1e6;
+      std::cout << std::left << std::setw(19) << name << " | " << std::setw(29)
+                << to_string(SceneFeatures::of(scene)) << " | " << std::setw(10) << to_string(engine) << " | "
+                << std::right << std::fixed << std::setprecision(3) << std::setw(13) << generic << " | "
+                << std::setw(17) << specialized << " | " << std::setprecision(2) << std::setw(6)
+                << specialized / generic << "x\n";
+    }
+  }
+  std::cout << std::flush;
+}
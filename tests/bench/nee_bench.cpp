@@ -0,0 +1,45 @@
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// The light/BSDF mixture against next-event estimation with each MIS heuristic, on the scenes lit by their lights:
+// samples/s and the frame's mean relative error at --spp, then the time each needs to bring the frame to the same
+// error (RenderSettings::error_target).
+void nee_bench(const BenchOptions &options) {
+  const double error_target = 0.1;
+
+  std::cout << "scene        | lighting    | samples/s (M) | error at spp | s to error " << error_target << " | spp\n";
+
+  for (auto name : {"cornell_box", "simple_light"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.samples_per_pixel = options.spp;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+
+    const DirectLighting variants[] = {{false, MisHeuristic::Power},
+                                       {true, MisHeuristic::Balance},
+                                       {true, MisHeuristic::Power}};
+    for (const auto &direct : variants) {
+      RenderSettings settings;
+      settings.direct_lighting = direct;
+
+      ConvergenceTiming timing = time_to_error(scene, world, settings, error_target, options.repeat);
+
+      std::string lighting = direct.next_event_estimation ? std::string("nee/") + to_string(direct.heuristic)
+                                                          : std::string("mixture");
+      std::cout << std::left << std::setw(12) << name << " | " << std::setw(11) << lighting << " | " << std::right
+                << std::fixed << std::setprecision(3) << std::setw(13) << timing.totals.samples / timing.seconds / 1e6
+                << " | " << std::setw(12) << timing.relative_error << " | " << std::setw(15) << timing.error_seconds
+                << " | " << std::setprecision(1) << timing.error_spp << "\n";
+    }
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Shadow ray queries/s, closest hit against occluded(): segments from the camera ray hit points to random points
+// of the scene bounds, the kind of visibility test light sampling makes.
+void occlusion_bench(const BenchOptions &options) {
+  std::cout << "scene               | hit (M rays/s) | occluded (M rays/s) | speedup | blocked\n";
+
+  for (auto name : {"quads", "random_scene", "cornell_box", "final_scene"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+    const aabb bounds = world.bounding_box();
+
+    Random::set_seed(0);
+    std::vector<ray> rays;
+    const int width = scene.cam.image_width, height = scene.cam.image_height;
+    for (int sample = 0; sample < std::max(1, options.spp); ++sample) {
+      for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+          hit_record rec;
+          ray r = scene.cam.get_ray((i + random_double()) / width, (j + random_double()) / height);
+          if (!world.hit(r, interval(0.001, math::infinity), rec)) continue;
+          point3 target(random_double(bounds.x.min, bounds.x.max), random_double(bounds.y.min, bounds.y.max),
+                        random_double(bounds.z.min, bounds.z.max));
+          rays.emplace_back(rec.p, target - rec.p, r.time());
+        }
+      }
+    }
+
+    // The segment ends at the target, t = 1
+    const interval segment(0.001, 1.0);
+    double best_hit = 0, best_occluded = 0;
+    long long blocked = 0;
+    for (int run = 0; run < std::max(1, options.repeat); ++run) {
+      auto start = std::chrono::steady_clock::now();
+      hit_record rec;
+      for (const ray &r : rays) world.hit(r, segment, rec);
+      auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || seconds < best_hit) best_hit = seconds;
+
+      blocked = 0;
+      start = std::chrono::steady_clock::now();
+      for (const ray &r : rays) blocked += world.occluded(r, segment);
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || seconds < best_occluded) best_occluded = seconds;
+    }
+
+    const double count = std::max<double>(1, rays.size());
+    std::cout << std::left << std::setw(19) << name << " | " << std::right << std::fixed << std::setprecision(3)
+              << std::setw(14) << count / best_hit / 1e6 << " | " << std::setw(19) << count / best_occluded / 1e6
+              << " | " << std::setprecision(2) << std::setw(6) << best_hit / best_occluded << "x | " << std::setw(6)
+              << std::setprecision(1) << 100.0 * blocked / count << "%\n";
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Camera rays/s through the BVH alone, one ray at a time against RayPacket packets of neighbouring pixels in a row,
+// the way the wavefront engine packs them. No shading, so the difference is all traversal.
+void packet_bench(const BenchOptions &options) {
+  std::cout << "scene               | single (M rays/s) | packets (M rays/s) | speedup\n";
+
+  for (auto name : {"two_diffuse_spheres", "quads", "random_scene", "cornell_box", "final_scene"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+
+    // A pass of one sample per pixel, scanline order, `spp` times
+    Random::set_seed(0);
+    std::vector<ray> rays;
+    const int width = scene.cam.image_width, height = scene.cam.image_height;
+    for (int sample = 0; sample < std::max(1, options.spp); ++sample) {
+      for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+          rays.push_back(scene.cam.get_ray((i + random_double()) / width, (j + random_double()) / height));
+        }
+      }
+    }
+
+    double best_single = 0, best_packets = 0;
+    for (int run = 0; run < std::max(1, options.repeat); ++run) {
+      auto start = std::chrono::steady_clock::now();
+      hit_record rec;
+      for (const ray &r : rays) world.hit(r, interval(0.001, math::infinity), rec);
+      auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || seconds < best_single) best_single = seconds;
+
+      start = std::chrono::steady_clock::now();
+      RayPacket packet;
+      hit_record recs[RayPacket::width];
+      real t_max[RayPacket::width];
+      for (size_t first = 0; first < rays.size(); first += RayPacket::width) {
+        packet.clear();
+        for (size_t k = first; k < std::min(rays.size(), first + RayPacket::width); ++k) packet.push(rays[k]);
+        std::fill(std::begin(t_max), std::end(t_max), math::infinity);
+        world.hit_packet(packet, packet.mask(), 0.001, t_max, recs);
+      }
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || seconds < best_packets) best_packets = seconds;
+    }
+
+    std::cout << std::left << std::setw(19) << name << " | " << std::right << std::fixed << std::setprecision(3)
+              << std::setw(17) << rays.size() / best_single / 1e6 << " | " << std::setw(18)
+              << rays.size() / best_packets / 1e6 << " | " << std::setprecision(2) << std::setw(6)
+              << best_single / best_packets << "x\n";
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+namespace {
+
+// Best of `repeat` runs of `body`, in millions of `count` operations per second
+double best_rate(int repeat, double count, const std::function<void()> &body) {
+  double best = 0;
+  for (int run = 0; run < std::max(1, repeat); ++run) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (run == 0 || seconds < best) best = seconds;
+  }
+  return count / best / 1e6;
+}
+
+}  // namespace
+
+// The cost of a random number on its own, of setting up a sample's stream, and then in whole renders of
+// --scene (cornell_box by default). --width² × --spp numbers per kernel.
+void random_bench(const BenchOptions &options) {
+  std::cout << "kernel                 | M ops/s\n";
+  auto report = [](const std::string &kernel, double rate) {
+    std::cout << std::left << std::setw(22) << kernel << " | " << std::right << std::fixed << std::setprecision(2)
+              << std::setw(7) << rate << "\n";
+  };
+
+  Random::set_seed(1);
+  const long long count = static_cast<long long>(options.width) * options.width * std::max(1, options.spp);
+  volatile double sink = 0;
+
+  report("random_double", best_rate(options.repeat, count, [&] {
+           double sum = 0;
+           for (long long i = 0; i < count; ++i) sum += random_double();
+           sink = sum;
+         }));
+  report("random_int", best_rate(options.repeat, count, [&] {
+           long long sum = 0;
+           for (long long i = 0; i < count; ++i) sum += random_int(0, 99);
+           sink = static_cast<double>(sum);
+         }));
+  report("random_unit_vector", best_rate(options.repeat, count, [&] {
+           vec3 sum(0, 0, 0);
+           for (long long i = 0; i < count; ++i) sum += random_unit_vector();
+           sink = sum.x();
+         }));
+  // One stream per sample, as camera_ray() sets them up, and a few numbers from each
+  report("sample_stream", best_rate(options.repeat, count, [&] {
+           double sum = 0;
+           for (long long i = 0; i < count; ++i) {
+             Random::set_sample_stream(static_cast<uint64_t>(i) / 16, static_cast<uint64_t>(i) % 16);
+             sum += random_double() + random_double();
+           }
+           sink = sum;
+         }));
+
+  const std::string name = options.scene.empty() ? "cornell_box" : options.scene;
+  Scene scene = Scene::SceneMap[name]();
+  scene.cam.image_width = options.width;
+  scene.cam.samples_per_pixel = options.spp;
+  scene.cam.initialize();
+  bvh_node world(scene.world);
+  Image image(scene.cam.image_width, scene.cam.image_height);
+  for (auto engine : {RenderEngine::Megakernel, RenderEngine::Wavefront}) {
+    ProgressSnapshot total;
+    const double rate = best_rate(options.repeat, 1, [&] {
+      Renderer renderer;
+      RenderProgress progress;
+      renderer.settings.engine = engine;
+      renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+      {
+        QuietCout quiet;
+        renderer.render(scene, world, image, &progress);
+      }
+      total = progress.snapshot();
+    });
+    report(name + " " + to_string(engine), rate * total.samples);
+  }
+  Random::set_seed(0);
+  std::cout << std::flush;
+}
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Russian roulette from a few start depths against fixed-depth paths: raw speed at --spp, then the time each
+// needs to bring the frame to the same mean relative error (RenderSettings::error_target).
+void roulette_bench(const BenchOptions &options) {
+  const double error_target = 0.1;
+
+  std::cout << "scene        | paths    |   rays/s (M) | samples/s (M) | rays / sample | s to error " << error_target
+            << " | spp\n";
+
+  for (auto name : {"cornell_box", "random_scene"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.samples_per_pixel = options.spp;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+
+    for (int start_depth : {-1, 2, 3, 5, 8}) {  // -1: fixed depth
+      RenderSettings settings;
+      settings.roulette.enabled = start_depth >= 0;
+      settings.roulette.start_depth = start_depth;
+
+      ConvergenceTiming timing = time_to_error(scene, world, settings, error_target, options.repeat);
+      const ProgressSnapshot &totals = timing.totals;
+
+      std::string paths = start_depth >= 0 ? "rr@" + std::to_string(start_depth) : "fixed";
+      std::cout << std::left << std::setw(12) << name << " | " << std::setw(8) << paths << " | " << std::right
+                << std::fixed << std::setprecision(3) << std::setw(12) << totals.rays / timing.seconds / 1e6 << " | "
+                << std::setw(13) << totals.samples / timing.seconds / 1e6 << " | " << std::setprecision(2)
+                << std::setw(13) << static_cast<double>(totals.rays) / std::max<uint64_t>(1, totals.samples) << " | "
+                << std::setprecision(3) << std::setw(15) << timing.error_seconds << " | " << std::setprecision(1)
+                << timing.error_spp << "\n";
+    }
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Engine configurations compared by throughput_bench().
+struct EngineVariant {
+  const char *label;
+  RenderEngine engine;
+  bool sort_by_material;
+  bool sort_rays;
+  bool packets;
+};
+
+// Samples/s and rays/s of a plain render with each engine variant, from a cheap scene where per-sample overhead
+// shows up to ones where tracing dominates, and mixed-material ones.
+void throughput_bench(const BenchOptions &options) {
+  const EngineVariant variants[] = {
+      {"megakernel", RenderEngine::Megakernel, false, false, false},
+      {"wavefront", RenderEngine::Wavefront, false, false, false},
+      {"wf+sort", RenderEngine::Wavefront, true, false, false},
+      {"wf+rays", RenderEngine::Wavefront, false, true, false},
+      {"wf+packets", RenderEngine::Wavefront, false, false, true},
+  };
+
+  std::cout << "scene               | engine     | samples/s (M) |   rays/s (M) | rays / sample\n";
+
+  for (auto name : {"two_diffuse_spheres", "quads", "random_scene", "material_showcase", "cornell_box",
+                    "final_scene"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.samples_per_pixel = options.spp;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+    Image image(scene.cam.image_width, scene.cam.image_height);
+
+    // Variants take turns within each run, so a slow stretch of the machine hits all of them alike
+    const size_t count = std::size(variants);
+    std::vector<double> best_seconds(count, 0);
+    std::vector<ProgressSnapshot> totals(count);
+    for (int run = 0; run < std::max(1, options.repeat); ++run) {
+      for (size_t v = 0; v < count; ++v) {
+        Renderer renderer;
+        RenderProgress progress;
+        renderer.settings.engine = variants[v].engine;
+        renderer.settings.sort_by_material = variants[v].sort_by_material;
+        renderer.settings.sort_rays = variants[v].sort_rays;
+        renderer.settings.packet_camera_rays = variants[v].packets;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+
+        // Unseeded, so the runs do not all trace the same paths. Seeded renders are as fast: every sample switches
+        // to its own random stream either way.
+        Random::set_seed(0);
+        auto start = std::chrono::steady_clock::now();
+        {
+          QuietCout quiet;
+          renderer.render(scene, world, image, &progress);
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 0 || seconds < best_seconds[v]) best_seconds[v] = seconds;
+        totals[v] = progress.snapshot();
+      }
+    }
+
+    for (size_t v = 0; v < count; ++v) {
+      std::cout << std::left << std::setw(19) << name << " | " << std::setw(10) << variants[v].label << " | "
+                << std::right << std::fixed << std::setprecision(3) << std::setw(13)
+                << totals[v].samples / best_seconds[v] / 1e6 << " | " << std::setw(12)
+                << totals[v].rays / best_seconds[v] / 1e6 << " | " << std::setprecision(2) << std::setw(13)
+                << static_cast<double>(totals[v].rays) / std::max<uint64_t>(1, totals[v].samples) << "\n";
+    }
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+// Camera rays/s and cache misses of each PixelOrder, on a texture heavy scene (earth) and a BVH heavy one
+// (random_scene).
+void traversal_bench(const BenchOptions &options) {
+  std::cout << "scene        | order    |   rays/s (M) | cache misses / ray\n";
+
+  for (auto name : {"random_scene", "earth"}) {
+    if (!options.wants(name)) continue;
+    Scene scene = Scene::SceneMap[name]();
+    scene.cam.image_width = options.width;
+    scene.cam.samples_per_pixel = options.spp;
+    scene.cam.initialize();
+    bvh_node world(scene.world);
+    Image image(scene.cam.image_width, scene.cam.image_height);
+
+    for (auto order : {PixelOrder::Scanline, PixelOrder::Morton, PixelOrder::Hilbert}) {
+      double best_seconds = 0;
+      uint64_t best_misses = 0;
+      long long samples = 0;
+      bool counted = false;
+
+      for (int run = 0; run < std::max(1, options.repeat); ++run) {
+        // Opened before the renderer starts its workers, so they inherit it.
+        CacheMissCounter misses;
+        Renderer renderer;
+        renderer.settings.pixel_order = order;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+
+        Random::set_seed(1234);
+        misses.start();
+        auto start = std::chrono::steady_clock::now();
+        {
+          QuietCout quiet;
+          renderer.render(scene, world, image);
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto miss_count = misses.stop();
+
+        if (run == 0 || seconds < best_seconds) {
+          best_seconds = seconds;
+          best_misses = miss_count;
+        }
+        samples = renderer.film.get_total_sample_count();
+        counted = misses.available();
+      }
+
+      std::cout << std::left << std::setw(12) << name << " | " << std::setw(8) << to_string(order) << " | "
+                << std::right << std::fixed << std::setprecision(3) << std::setw(12) << samples / best_seconds / 1e6
+                << " | ";
+      if (counted) {
+        std::cout << std::setprecision(2) << std::setw(18) << static_cast<double>(best_misses) / samples << "\n";
+      } else {
+        std::cout << std::setw(18) << "n/a" << "\n";
+      }
+    }
+  }
+  std::cout << std::flush;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.h"
+#include "core/hittables/bvh_node.h"
+#include "core/hittables/sphere.h"
+#include "core/material.h"
+#include "core/onb.h"
+#include "core/render.h"
+
+using namespace glimpse;
+
+namespace {
+
+// Best of `repeat` runs of `body`, in millions of `count` operations per second
+double best_rate(int repeat, double count, const std::function<void()> &body) {
+  double best = 0;
+  for (int run = 0; run < std::max(1, repeat); ++run) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (run == 0 || seconds < best) best = seconds;
+  }
+  return count / best / 1e6;
+}
+
+}  // namespace
+
+// The vec3 arithmetic on its own, then in the three places that lean on it most: onb::transform(), sphere::hit()
+// and ray_color(). Run it in a build with and one without USE_SIMD_VEC3 to compare the backends, the same way
+// USE_AVX2 is compared. --width sets the size of the vector arrays (width² vectors), --spp the passes over them.
+void vec3_bench(const BenchOptions &options) {
+#if !defined(GLIMPSE_SIMD_VEC3)
+  const char *backend = "scalar";
+#elif defined(__AVX2__)
+  const char *backend = "avx2";
+#else
+  const char *backend = "sse2";
+#endif
+  std::cout << "vec3 backend: " << backend << ", " << sizeof(vec3) << " bytes per vec3\n";
+  std::cout << "kernel             | M ops/s\n";
+
+  Random::set_seed(0);
+  const size_t count = static_cast<size_t>(options.width) * options.width;
+  const int passes = std::max(1, options.spp);
+  std::vector<vec3> a(count), b(count), out(count);
+  for (size_t i = 0; i < count; ++i) {
+    a[i] = vec3::random(-1, 1);
+    b[i] = vec3::random(-1, 1);
+  }
+  const double ops = static_cast<double>(count) * passes;
+  volatile real sink = 0;
+
+  auto report = [](const char *kernel, double rate) {
+    std::cout << std::left << std::setw(18) << kernel << " | " << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << rate << "\n";
+  };
+
+  report("add/mul", best_rate(options.repeat, ops, [&] {
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) out[i] = a[i] * b[i] + real(0.5) * out[i];
+           }
+         }));
+  report("dot", best_rate(options.repeat, ops, [&] {
+           real sum = 0;
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) sum += dot(a[i], b[i]);
+           }
+           sink = sum;
+         }));
+  report("cross", best_rate(options.repeat, ops, [&] {
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) out[i] = cross(a[i], b[i]);
+           }
+         }));
+  report("unit_vector", best_rate(options.repeat, ops, [&] {
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) out[i] = unit_vector(a[i]);
+           }
+         }));
+
+  // A handful of bases, as many transforms as vectors
+  std::vector<onb> bases;
+  for (size_t i = 0; i < 64; ++i) bases.emplace_back(b[i]);
+  report("onb::transform", best_rate(options.repeat, ops, [&] {
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) out[i] = bases[i % bases.size()].transform(a[i]);
+           }
+         }));
+
+  // Rays from around the sphere at it, most of them hit
+  sphere ball(point3(0, 0, 0), 1, make_shared<lambertian>(color(0.5, 0.5, 0.5)));
+  report("sphere::hit", best_rate(options.repeat, ops, [&] {
+           hit_record rec;
+           int hits = 0;
+           for (int pass = 0; pass < passes; ++pass) {
+             for (size_t i = 0; i < count; ++i) {
+               point3 origin = real(4) * a[i];
+               hits += ball.hit(ray(origin, b[i] * real(0.2) - origin), interval(0.001, math::infinity), rec);
+             }
+           }
+           sink = static_cast<real>(hits);
+         }));
+
+  // Whole paths, a pass of camera rays through random_scene
+  Scene scene = Scene::SceneMap["random_scene"]();
+  scene.cam.image_width = options.width;
+  scene.cam.initialize();
+  bvh_node world(scene.world);
+  const int width = scene.cam.image_width, height = scene.cam.image_height;
+  report("ray_color", best_rate(options.repeat, static_cast<double>(width) * height, [&] {
+           color sum(0, 0, 0);
+           for (int j = 0; j < height; ++j) {
+             for (int i = 0; i < width; ++i) {
+               ray r = scene.cam.get_ray((i + 0.5) / width, (j + 0.5) / height);
+               sum += ray_color(r, scene.background, world, scene.cam.max_depth, scene.lights, false);
+             }
+           }
+           sink = sum.x();
+         }));
+  std::cout << std::flush;
+}
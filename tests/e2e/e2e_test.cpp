@@ -125,25 +125,23 @@ void test_scene_uncapped(const std::string& name, Scene (*create_scene_fn)(), in
               << scene.cam.image_height << ")"
               << " for " << run_time_seconds << " seconds" << std::endl;
 
-    std::atomic<int> progress = 0;
+    RenderProgress progress;
     Renderer renderer;
+    CancelToken cancel;
 
     // Start rendering in a separate thread
     auto render_future =
-        std::async(std::launch::async, [&]() { renderer.render_scene(scene, rendered_image, &progress); });
+        std::async(std::launch::async, [&]() { renderer.render_scene(scene, rendered_image, &progress, cancel); });
 
     // Let it run for specified time
     std::this_thread::sleep_for(std::chrono::seconds(run_time_seconds));
 
     // Signal renderer to stop
-    Renderer::stop_rendering = true;
+    cancel.cancel();
 
     // Wait for renderer to finish
     render_future.wait();
 
-    // Reset flag for future tests
-    Renderer::stop_rendering = false;
-
     // Save rendered image
     bool write_success = rendered_image.write(output_filename);
     expect(write_success) << "Failed to write uncapped output image to " << output_filename;
@@ -187,7 +185,7 @@ void test_debug_scene() {
               << std::endl;
 
     // Render synchronously (no need for async with tiny image)
-    std::atomic<int> progress = 0;
+    RenderProgress progress;
     Renderer renderer;
     renderer.render_scene(scene, rendered_image, &progress);
 
@@ -314,14 +312,15 @@ void test_scene(const std::string& name, Scene (*create_scene_fn)(), int width =
               << ")"
               << " with " << scene.cam.samples_per_pixel << " samples" << std::endl;
 
-    std::atomic<int> progress = 0;
+    RenderProgress progress;
     std::atomic<bool> render_completed = false;
     Renderer renderer;
+    CancelToken cancel;
     renderer.render_scene(scene, rendered_image, &progress);
 
     // start render in a sperate thread!
     auto render_future = std::async(std::launch::async, [&]() {
-      renderer.render_scene(scene, rendered_image, &progress);
+      renderer.render_scene(scene, rendered_image, &progress, cancel);
       render_completed = true;
     });
 
@@ -340,7 +339,7 @@ void test_scene(const std::string& name, Scene (*create_scene_fn)(), int width =
         timed_out = true;
         std::cout << "Rendering timed out after " << timeout_seconds << " seconds" << std::endl;
 
-        Renderer::stop_rendering = true;  // Stop rendering
+        cancel.cancel();  // Stop rendering
 
         break;
       }
@@ -361,11 +360,6 @@ void test_scene(const std::string& name, Scene (*create_scene_fn)(), int width =
       std::cout << "Proceeding with comparison after forced stop." << std::endl;
     }
 
-    // Reset the global stop flag for future tests!
-    // TODO: Maybe this shouldnt be a global state afterall,
-    // or maybe it should be reset in the renderer instance destructor itself
-    Renderer::stop_rendering = false;
-
     // Save rendered image
     bool write_success = rendered_image.write(output_filename);
     expect(write_success) << "Failed to write output image to " << output_filename;
@@ -8,6 +8,8 @@
 #include "core/scenes.h"
 #include "core/vec3.h"
 
+using namespace glimpse;
+
 // Simple scene with a single sphere
 inline Scene create_simple_sphere_scene() {
   Scene scene;
@@ -4,6 +4,11 @@
 #include "boost/ut.hpp"  // import boost.ut;
 namespace ut = boost::ut;
 
+// Every test TU must see the same runner specialization, otherwise each one instantiates the default
+// (junit) runner and the linker sees multiple definitions.
+template <>
+inline auto ut::cfg<ut::override> = ut::runner<ut::reporter<ut::printer>>{};
+
 // namespace cfg {
 // class reporter : public ut::reporter<ut::printer> {
 //  public:
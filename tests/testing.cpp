@@ -2,9 +2,6 @@
 #include "boost/ut.hpp"  // import boost.ut;
 #include "test_cfg.h"
 
-template <>
-auto ut::cfg<ut::override> = ut::runner<ut::reporter<ut::printer>>{};
-
 constexpr auto sum(auto... values) { return (values + ...); }
 
 void vec3_test();
@@ -23,6 +20,9 @@ void render_test();
 void sphere_test();
 void bvh_test();
 void random_test();
+void tile_scheduler_test();
+void pixel_order_test();
+void precision_test();
 
 // End-to-end tests
 void e2e_test();
@@ -90,6 +90,9 @@ int main(int argc, char** argv) {
   sphere_test();
   bvh_test();
   random_test();
+  tile_scheduler_test();
+  pixel_order_test();
+  precision_test();
 
   // E2E
   // e2e_test();
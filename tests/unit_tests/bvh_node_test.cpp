@@ -1,5 +1,7 @@
 #include "core/hittables/bvh_node.h"
 
+#include "core/hittables/moving_sphere.h"
+#include "core/hittables/quad.h"
 #include "core/hittables/sphere.h"
 #include "core/material.h"
 
@@ -63,6 +65,89 @@ void bvh_test() {
       expect(bvh.hit(r3, interval(0.001, glimpse::math::infinity), rec3) == false);
     };
 
+    "hit_packet"_test = [] {
+      // Spheres, a moving one, a box of quads and a rotated and moved one
+      hittable_list list;
+      auto mat = make_shared<lambertian>(color(0.5, 0.5, 0.5));
+      for (int i = -2; i <= 2; i++) {
+        for (int j = -2; j <= 2; j++) list.add(make_shared<sphere>(point3(i * 1.5, j * 1.5, 0), 0.6, mat));
+      }
+      list.add(make_shared<sphere>(point3(0, 0, -2), point3(0, 1, -2), 0.5, mat));
+      list.add(box(point3(-1, -1, -4), point3(1, 1, -3), mat));
+      list.add(make_shared<translate>(make_shared<rotate_y>(box(point3(0, -1, 0), point3(1, 1, 1), mat), 30),
+                                      vec3(2, 0, -4)));
+      bvh_node bvh(list);
+
+      // A grid of coherent camera rays, packed a row at a time as the wavefront engine does
+      const point3 eye(0, 0, -10);
+      const int width = 40, height = 24;
+      int mismatches = 0, hits = 0;
+      for (int row = 0; row < height; row++) {
+        for (int first = 0; first < width; first += RayPacket::width) {
+          RayPacket packet;
+          for (int lane = 0; lane < RayPacket::width && first + lane < width; lane++) {
+            vec3 direction((first + lane - width / 2) * 0.025, (row - height / 2) * 0.025, 1);
+            packet.push(ray(eye, direction, (row % 4) / 3.0));
+          }
+
+          // Every other packet traces only some of its lanes
+          const int active = first % 16 == 0 ? packet.mask() : packet.mask() & 0b10110101;
+          real t_max[RayPacket::width];
+          for (auto &t : t_max) t = glimpse::math::infinity;
+          hit_record recs[RayPacket::width];
+          int packet_hits = bvh.hit_packet(packet, active, 0.001, t_max, recs);
+          expect((packet_hits & ~active) == 0_i);
+
+          for (int lane = 0; lane < packet.count; lane++) {
+            if (!(active >> lane & 1)) continue;
+            hit_record rec;
+            bool single_hit = bvh.hit(packet.get_ray(lane), interval(0.001, glimpse::math::infinity), rec);
+            bool lane_hit = (packet_hits >> lane & 1) != 0;
+            hits += single_hit;
+            if (single_hit != lane_hit) {
+              mismatches++;
+            } else if (single_hit) {
+              const hit_record &lane_rec = recs[lane];
+              bool same = rec.t == lane_rec.t && t_max[lane] == rec.t && rec.p == lane_rec.p &&
+                          rec.normal == lane_rec.normal && rec.front_face == lane_rec.front_face &&
+                          rec.u == lane_rec.u && rec.v == lane_rec.v && rec.mat == lane_rec.mat;
+              mismatches += !same;
+            }
+          }
+        }
+      }
+      expect(hits > 100_i);
+      expect(mismatches == 0_i);
+    };
+
+    "occluded"_test = [] {
+      Random::set_seed(5);
+      hittable_list list;
+      auto mat = make_shared<lambertian>(color(0.5, 0.5, 0.5));
+      for (int i = 0; i < 20; i++) list.add(make_shared<sphere>(vec3::random(-4, 4), random_double(0.2, 1), mat));
+      list.add(make_shared<moving_sphere>(point3(0, 0, 0), point3(0, 1, 0), 0.5, mat));
+      list.add(box(point3(-1, -1, 2), point3(1, 1, 3), mat));
+      list.add(make_shared<translate>(make_shared<rotate_y>(box(point3(0, 0, 0), point3(1, 2, 1), mat), 45),
+                                      vec3(-3, 0, -3)));
+      bvh_node bvh(list);
+
+      // Segments between random points, some open ended, agree with a closest hit query
+      int mismatches = 0, blocked = 0;
+      for (int k = 0; k < 2000; k++) {
+        point3 from = vec3::random(-6, 6);
+        ray r(from, vec3::random(-6, 6) - from, random_double());
+        interval segment(0.001, k % 4 == 0 ? glimpse::math::infinity : 1.0);
+        hit_record rec;
+        bool hit = bvh.hit(r, segment, rec);
+        blocked += hit;
+        mismatches += bvh.occluded(r, segment) != hit;
+      }
+      expect(blocked > 200_i);
+      expect(blocked < 1800_i);
+      expect(mismatches == 0_i);
+      Random::set_seed(0);
+    };
+
     skip / "empty_list"_test = [] {
       // Test with empty list
       hittable_list empty_list;
@@ -66,6 +66,29 @@ void camera_test() {
       expect(r1.origin() != r2.origin());
     };
 
+    "specialized_rays"_test = [] {
+      camera cam;
+      cam.defocus_angle = 2.0;
+      cam.lookfrom = point3(0, 0, 0);
+      cam.lookat = point3(0, 0, -1);
+      cam.initialize();
+
+      // Without defocus and motion: through the lens center, at time 0
+      ray still = cam.get_ray<false, false>(0.25, 0.75);
+      expect(still.origin() == cam.lookfrom);
+      expect(still.time() == 0.0_d);
+
+      // Everything enabled is get_ray(), draw for draw
+      Random::set_seed(5);
+      ray generic = cam.get_ray(0.25, 0.75);
+      Random::set_seed(5);
+      ray full = cam.get_ray<true, true>(0.25, 0.75);
+      Random::set_seed(0);
+      expect(generic.origin() == full.origin());
+      expect(generic.direction() == full.direction());
+      expect(generic.time() == full.time());
+    };
+
     "camera_movement"_test = [] {
       camera cam;
       point3 original_lookfrom = point3(0, 0, 0);
@@ -77,4 +77,43 @@ void film_test() {
     f.add_sample(1, 1, vec3(1.0f, 1.0f, 1.0f));
     expect(f.get_sample_count(1, 1) == 1_i);
   };
-}
\ No newline at end of file
+
+  "film.variance"_test = [] {
+    Film f(1, 1);
+    f.add_sample(0, 0, vec3(1.0, 2.0, 3.0));
+    f.add_sample(0, 0, vec3(3.0, 2.0, 5.0));
+    f.add_sample(0, 0, vec3(5.0, 2.0, 7.0));
+
+    auto mean = f.get_mean(0, 0);
+    expect(mean.x() == 3.0_d);
+    expect(mean.z() == 5.0_d);
+
+    // sample variance of {1, 3, 5} is 4
+    auto variance = f.get_variance(0, 0);
+    expect(std::abs(variance.x() - 4.0) < 1e-12);
+    expect(variance.y() == 0.0_d);
+    expect(std::abs(variance.z() - 4.0) < 1e-12);
+
+    // sqrt((4 + 0 + 4) / (3 * 3)) / mean(3, 2, 5)
+    expect(std::abs(f.get_relative_error(0, 0) - std::sqrt(8.0 / 9.0) / (10.0 / 3.0)) < 1e-12);
+  };
+
+  "film.relative_error"_test = [] {
+    Film f(2, 1);
+
+    // Not enough samples to say anything yet
+    f.add_sample(0, 0, vec3(1, 1, 1));
+    expect(f.get_relative_error(0, 0) == glimpse::math::infinity);
+
+    // Constant samples have converged
+    f.add_sample(0, 0, vec3(1, 1, 1));
+    expect(f.get_relative_error(0, 0) == 0.0_d);
+
+    expect(f.get_total_sample_count() == 2_ll);
+
+    // clear() keeps the size but drops the samples
+    f.clear();
+    expect(f.width() == 2_i);
+    expect(f.get_sample_count(0, 0) == 0_i);
+  };
+}
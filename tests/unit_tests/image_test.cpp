@@ -1,5 +1,6 @@
 #include "core/image.h"
 
+#include <filesystem>
 #include <iomanip>
 
 #include "../test_cfg.h"
@@ -116,6 +117,9 @@ void image_test() {
 void test_image_roundtrip() {
   using namespace boost::ut;
 
+  // Roundtrip tests write into ./test_output, which only the e2e tests used to create.
+  std::filesystem::create_directories("./test_output");
+
   test("image_initialization") = [] {
     Image img(100, 100);
     expect(img.width == 100_i);
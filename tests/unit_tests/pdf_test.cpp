@@ -13,7 +13,7 @@ void pdf_test() {
 
       // Test value method - should return 1/(4π) for any direction
       vec3 dir(1.0, 0.0, 0.0);
-      expect(pdf.value(dir) == 1.0 / (4 * glimpse::math::pi)) << "Sphere PDF value should be 1/(4π)";
+      expect(pdf.value(dir) == real(1.0 / (4 * glimpse::math::pi))) << "Sphere PDF value should be 1/(4π)";
 
       // Test generate method - should return a unit vector
       vec3 generated = pdf.generate();
@@ -27,7 +27,8 @@ void pdf_test() {
 
       // Test value method with various directions
       vec3 same_dir(0.0, 0.0, 1.0);
-      expect(pdf.value(same_dir) == 1.0 / glimpse::math::pi) << "Cosine PDF value in normal direction should be 1/π";
+      expect(pdf.value(same_dir) == real(1.0 / glimpse::math::pi))
+          << "Cosine PDF value in normal direction should be 1/π";
 
       vec3 perp_dir(1.0, 0.0, 0.0);
       expect(pdf.value(perp_dir) == 0.0_d) << "Cosine PDF value in perpendicular direction should be 0";
@@ -77,7 +78,7 @@ void pdf_test() {
 
       // Test value method - should be average of the two component PDFs
       vec3 dir(0.0, 0.0, 1.0);
-      double expected_value = 0.5 * pdf1->value(dir) + 0.5 * pdf2->value(dir);
+      real expected_value = 0.5 * pdf1->value(dir) + 0.5 * pdf2->value(dir);
       expect(mixed.value(dir) == expected_value) << "Mixture PDF value should be average of component values";
 
       // Test generate method - multiple calls should eventually generate samples from both PDFs
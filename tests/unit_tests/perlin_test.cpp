@@ -91,6 +91,8 @@ void perlin_test() {
     };
 
     "noise_interpolation"_test = [] {
+      // The lattice is random, so pin the seed to keep this comparison deterministic.
+      Random::set_seed(1234);
       perlin noise;
 
       // Test that nearby points have somewhat similar noise values
@@ -0,0 +1,67 @@
+#include "core/pixel_order.h"
+
+#include <cstdlib>
+#include <set>
+#include <utility>
+
+//
+#include "../test_cfg.h"
+
+using namespace glimpse;
+
+void pixel_order_test() {
+  using namespace boost::ut;
+
+  "pixel_order"_test = [] {
+    "visits_every_pixel_once"_test = [] {
+      // 16 is a power of two, 12 needs the curves clipped
+      for (int tile_size : {1, 12, 16}) {
+        for (auto order : {PixelOrder::Scanline, PixelOrder::Morton, PixelOrder::Hilbert}) {
+          auto offsets = tile_traversal(order, tile_size);
+          expect(offsets.size() == static_cast<size_t>(tile_size * tile_size)) << to_string(order);
+
+          std::set<std::pair<int, int>> seen;
+          for (auto offset : offsets) {
+            expect(offset.x >= 0_i && offset.x < tile_size);
+            expect(offset.y >= 0_i && offset.y < tile_size);
+            seen.insert({offset.x, offset.y});
+          }
+          expect(seen.size() == offsets.size()) << to_string(order);
+        }
+      }
+    };
+
+    "scanline"_test = [] {
+      // Top row first, left to right
+      auto offsets = tile_traversal(PixelOrder::Scanline, 4);
+      expect(offsets[0].x == 0_i && offsets[0].y == 3_i);
+      expect(offsets[1].x == 1_i && offsets[1].y == 3_i);
+      expect(offsets[4].x == 0_i && offsets[4].y == 2_i);
+    };
+
+    "morton"_test = [] {
+      // x takes the even bits, y the odd ones
+      expect(morton_decode(0).x == 0_i && morton_decode(0).y == 0_i);
+      expect(morton_decode(1).x == 1_i && morton_decode(1).y == 0_i);
+      expect(morton_decode(2).x == 0_i && morton_decode(2).y == 1_i);
+      expect(morton_decode(3).x == 1_i && morton_decode(3).y == 1_i);
+      expect(morton_decode(0b110110).x == 6_i && morton_decode(0b110110).y == 5_i);
+    };
+
+    "hilbert_steps_to_neighbours"_test = [] {
+      auto offsets = tile_traversal(PixelOrder::Hilbert, 16);
+      for (size_t k = 1; k < offsets.size(); ++k) {
+        int distance = std::abs(offsets[k].x - offsets[k - 1].x) + std::abs(offsets[k].y - offsets[k - 1].y);
+        expect(distance == 1_i);
+      }
+    };
+
+    "parse"_test = [] {
+      PixelOrder order = PixelOrder::Scanline;
+      expect(parse_pixel_order("hilbert", order));
+      expect(order == PixelOrder::Hilbert);
+      expect(!parse_pixel_order("spiral", order));
+      expect(order == PixelOrder::Hilbert);
+    };
+  };
+}
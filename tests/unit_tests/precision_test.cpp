@@ -0,0 +1,110 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "../e2e/test_scenes.h"
+#include "core/hittables/bvh_node.h"
+#include "core/scenes.h"
+#include "core/vec3.h"
+#include "core/wavefront.h"
+
+//
+#include "../test_cfg.h"
+
+using namespace glimpse;
+
+namespace {
+
+struct AcneCount {
+  int rays = 0;
+  int self_hits = 0;
+};
+
+// Shoots the camera rays of a coarse image at the scene and, from every hit, rays into the hemisphere the surface
+// faces, spawned the way the renderer spawns them (hit_record::spawn_ray(), self_intersection_epsilon()). Such a ray
+// cannot find the surface it leaves again, so a hit next to its origin on a surface parallel to that one is acne.
+// With `hit_queue`, the hits first go through the wavefront engine's HitQueue, as shade() gets them.
+AcneCount count_acne(Scene scene, int width, int rays_per_hit, bool hit_queue) {
+  scene.cam.image_width = width;
+  scene.cam.defocus_angle = 0;
+  scene.cam.initialize();
+  bvh_node world(scene.world);
+
+  AcneCount count;
+  const int height = scene.cam.image_height;
+  for (int j = 0; j < height; ++j) {
+    for (int i = 0; i < width; ++i) {
+      hit_record rec;
+      ray r = scene.cam.get_ray((i + 0.5) / width, (j + 0.5) / height);
+      if (!world.hit(r, interval(self_intersection_epsilon(r.origin()), math::infinity), rec)) continue;
+      if (hit_queue) {
+        HitQueue queue;
+        queue.push(0, rec);
+        rec = queue.get_record(0);
+      }
+
+      for (int k = 0; k < rays_per_hit; ++k) {
+        ray leaving = rec.spawn_ray(random_on_hemisphere(rec.normal), r.time());
+        hit_record again;
+        count.rays++;
+        if (!world.hit(leaving, interval(self_intersection_epsilon(leaving.origin()), math::infinity), again)) {
+          continue;
+        }
+        if ((again.p - rec.p).length() < 0.01 && std::abs(dot(again.normal, rec.normal)) > 0.9) count.self_hits++;
+      }
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void precision_test() {
+  using namespace boost::ut;
+
+  "precision"_test = [] {
+    "float_matches_double"_test = [] {
+      basic_vec3<double> u(1.5, -2.25, 3.125), v(-0.75, 4.5, 0.375);
+      basic_vec3<float> uf(u), vf(v);
+      const double tolerance = 8 * std::numeric_limits<float>::epsilon();
+
+      expect(std::abs(dot(uf, vf) - dot(u, v)) <= tolerance * u.length() * v.length());
+      bool same_cross = true, same_unit = true;
+      for (int i = 0; i < 3; ++i) {
+        same_cross &= std::abs(cross(uf, vf)[i] - cross(u, v)[i]) <= tolerance * u.length() * v.length();
+        same_unit &= std::abs(unit_vector(uf)[i] - unit_vector(u)[i]) <= tolerance;
+      }
+      expect(same_cross);
+      expect(same_unit);
+    };
+
+    "self_intersection_epsilon"_test = [] {
+      // 0.001 across the scenes, more only once a coordinate's rounding error could reach it
+      expect(self_intersection_epsilon(basic_vec3<double>(0, 0, 0)) == 0.001_d);
+      expect(self_intersection_epsilon(basic_vec3<double>(555, -1000, 278)) == 0.001_d);
+      expect(self_intersection_epsilon(basic_vec3<float>(1, 2, 3)) == 0.001_f);
+      expect(self_intersection_epsilon(basic_vec3<float>(1e6f, 0, 0)) > 1.0_f);
+      expect(self_intersection_epsilon(basic_vec3<float>(0, -2e6f, 0)) > self_intersection_epsilon(
+                                                                            basic_vec3<float>(0, -1e6f, 0)));
+    };
+
+    // In whichever precision real is, see the Glimpse_float_tests target
+    "no_surface_acne"_test = [] {
+      Random::set_seed(23);
+      const std::pair<std::string, Scene> scenes[] = {{"simple_sphere", create_simple_sphere_scene()},
+                                                      {"cornell_box", create_cornell_box_scene()},
+                                                      {"random_scene", Scene::SceneMap["random_scene"]()},
+                                                      {"quads", Scene::SceneMap["quads"]()}};
+      for (const auto &[name, scene] : scenes) {
+        for (bool hit_queue : {false, true}) {
+          AcneCount count = count_acne(scene, 64, 8, hit_queue);
+          expect(count.rays > 1000_i) << name;
+          expect(count.self_hits == 0_i) << name << (hit_queue ? "(wavefront)" : "(megakernel)") << ":"
+                                         << count.self_hits << "of" << count.rays;
+        }
+      }
+      Random::set_seed(0);
+    };
+  };
+}
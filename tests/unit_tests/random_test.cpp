@@ -1,4 +1,8 @@
+#include <climits>
+#include <cstdlib>
+#include <set>
 #include <thread>
+#include <vector>
 
 #include "core/common.h"
 
@@ -83,6 +87,87 @@ void random_test() {
     expect(thread1_values == thread2_values);
   };
 
+  "random_thread_default_stream"_test = [] {
+    // Threads that key their stream draw from their own, derived from the seed
+    auto first_draws = [] {
+      std::vector<double> values(2);
+      auto draw = [&values](int k) {
+        Random::init_thread();
+        values[k] = Random::double_value();
+      };
+      std::thread t1(draw, 0);
+      std::thread t2(draw, 1);
+      t1.join();
+      t2.join();
+      return values;
+    };
+
+    Random::set_seed(99);
+    auto seeded = first_draws();
+    expect(seeded[0] != seeded[1]);
+
+    Random::set_seed(100);
+    auto reseeded = first_draws();
+    expect(reseeded[0] != seeded[0] && reseeded[0] != seeded[1]);
+    Random::set_seed(0);
+  };
+
+  "random_sample_stream"_test = [] {
+    Random::set_seed(5);
+    auto draw = [](uint64_t pixel, uint64_t sample) {
+      Random::set_sample_stream(pixel, sample);
+      std::vector<double> values;
+      for (int i = 0; i < 4; i++) values.push_back(Random::double_value());
+      return values;
+    };
+
+    // A sample's numbers depend only on the seed, its pixel and its index, not on what was drawn before
+    auto first = draw(17, 3);
+    draw(18, 0);
+    Random::double_value();
+    expect(draw(17, 3) == first);
+
+    // Neighbouring pixels and samples get unrelated streams
+    std::set<double> firsts;
+    for (uint64_t pixel = 0; pixel < 32; pixel++) {
+      for (uint64_t sample = 0; sample < 32; sample++) firsts.insert(draw(pixel, sample)[0]);
+    }
+    expect(firsts.size() == 1024_ul);
+
+    // Another seed, other streams
+    Random::set_seed(6);
+    expect(draw(17, 3) != first);
+
+    // A saved stream picks up where it left off
+    Random::set_sample_stream(1, 2);
+    Random::double_value();
+    Random::Stream saved = Random::stream();
+    auto next = Random::double_value();
+    Random::set_sample_stream(3, 4);
+    Random::set_stream(saved);
+    expect(Random::double_value() == next);
+    Random::set_seed(0);
+  };
+
+  "random_int_uniform"_test = [] {
+    Random::set_seed(8);
+    int counts[7] = {};
+    const int draws = 70000;
+    for (int i = 0; i < draws; i++) counts[Random::int_value(-3, 3) + 3]++;
+    // 10000 expected in each bucket, with a standard deviation of about 93
+    bool uniform = true;
+    for (int count : counts) uniform = uniform && std::abs(count - draws / 7) < 500;
+    expect(uniform);
+
+    // The ends of int's range
+    expect(Random::int_value(INT_MIN, INT_MIN) == INT_MIN);
+    expect(Random::int_value(INT_MAX, INT_MAX) == INT_MAX);
+    bool negative = false;
+    for (int i = 0; i < 100; i++) negative = negative || Random::int_value(INT_MIN, INT_MAX) < 0;
+    expect(negative);
+    Random::set_seed(0);
+  };
+
   "random_default_seed"_test = [] {
     // Test that seed 0 gives different sequences each time
     Random::set_seed(0);
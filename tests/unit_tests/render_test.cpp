@@ -1,10 +1,21 @@
 #include "core/render.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <tuple>
+
 #include "core/hittables/bvh_node.h"
+#include "core/hittables/quad.h"
 #include "core/hittables/sphere.h"
 #include "core/image.h"
 #include "core/material.h"
 #include "core/ray.h"
+#include "core/scaling.h"
 #include "core/vec3.h"
 
 //
@@ -43,6 +54,21 @@ Scene create_test_scene() {
   return scene;
 }
 
+// Frame mean (sum of channels) and its standard error, from the Film's per-pixel variance
+std::pair<double, double> frame_mean(const Film &film) {
+  double mean = 0, variance = 0;
+  const double pixels = static_cast<double>(film.width()) * film.height();
+  for (int j = 0; j < film.height(); ++j) {
+    for (int i = 0; i < film.width(); ++i) {
+      auto m = film.get_mean(i, j);
+      auto v = film.get_variance(i, j);
+      mean += (m.x() + m.y() + m.z()) / pixels;
+      variance += (v.x() + v.y() + v.z()) / film.get_sample_count(i, j) / (pixels * pixels);
+    }
+  }
+  return {mean, std::sqrt(variance)};
+}
+
 void render_test() {
   using namespace boost::ut;
 
@@ -57,7 +83,7 @@ void render_test() {
       Scene scene = create_test_scene();
 
       // Test basic rendering
-      std::atomic<int> progress = 0;
+      RenderProgress progress;
       renderer.render_scene(scene, image, &progress);
 
       // here we need to wait for the rendering to finish
@@ -84,7 +110,7 @@ void render_test() {
       expect(has_content) << "Rendered image should contain some non-black pixels";
 
       // Progress should have been updated
-      expect(progress.load() > 0_i) << "Progress counter should be incremented during rendering";
+      expect(progress.snapshot().samples > 0_ull) << "Progress counter should be incremented during rendering";
     };
 
     "ray_color"_test = [] {
@@ -108,6 +134,181 @@ void render_test() {
       expect(c2 == background) << "Ray missing all objects should return background color";
     };
 
+    "ray_color_recursive"_test = [] {
+      // Same random draws per path, so both integrators follow the same path and only rounding differs.
+      // cornell_box mixes light sampling, random_scene has metal and glass (skip_pdf).
+      Random::set_seed(1234);
+      for (auto name : {"cornell_box", "random_scene"}) {
+        Scene scene = Scene::SceneMap[name]();
+        scene.cam.image_width = 16;
+        scene.cam.initialize();
+        auto bvh = bvh_node(scene.world);
+        const bool has_lights = !scene.lights.objects.empty();
+
+        // Relative, a hundred ulps more in float, where rounding reaches the 7th digit
+        const double tolerance = 1e-9 + 100 * std::numeric_limits<real>::epsilon();
+        int mismatches = 0;
+        double worst = 0;
+        for (int path = 0; path < 256; ++path) {
+          ray r = scene.cam.get_ray((path % 16) / 15.0, (path / 16) / 15.0);
+
+          Random::set_sample_stream(path, 0);
+          color iterative = ray_color(r, scene.background, bvh, scene.cam.max_depth, scene.lights, has_lights,
+                                      RussianRoulette{.enabled = false});
+          Random::set_sample_stream(path, 0);
+          color recursive =
+              ray_color_recursive(r, scene.background, bvh, scene.cam.max_depth, scene.lights, has_lights);
+
+          for (int c = 0; c < 3; ++c) {
+            double difference = std::abs(iterative[c] - recursive[c]) / std::max<double>(1.0, std::abs(recursive[c]));
+            if (difference > tolerance) mismatches++;
+            if (difference > worst) worst = difference;
+          }
+        }
+        expect(mismatches == 0_i) << name << worst;
+      }
+      Random::set_seed(0);
+    };
+
+    "russian_roulette"_test = [] {
+      Random::set_seed(99);
+      Scene scene = Scene::SceneMap["cornell_box"]();
+      scene.cam.image_width = 16;
+      scene.cam.initialize();
+      auto bvh = bvh_node(scene.world);
+      ray r = scene.cam.get_ray(0.5, 0.5);
+
+      // Mean brightness of one pixel and its standard error, with and without roulette
+      auto estimate = [&](const RussianRoulette &roulette) {
+        const int paths = 20000;
+        double sum = 0, sum_sq = 0;
+        for (int path = 0; path < paths; ++path) {
+          color c = ray_color(r, scene.background, bvh, scene.cam.max_depth, scene.lights, true, roulette);
+          double value = c.x() + c.y() + c.z();
+          sum += value;
+          sum_sq += value * value;
+        }
+        double mean = sum / paths;
+        return std::pair{mean, std::sqrt(std::max(0.0, sum_sq / paths - mean * mean) / paths)};
+      };
+
+      auto [fixed_mean, fixed_error] = estimate(RussianRoulette{.enabled = false});
+      auto [roulette_mean, roulette_error] = estimate(RussianRoulette{});
+      // Unbiased: the two agree within their noise
+      expect(std::abs(fixed_mean - roulette_mean) < 5 * std::hypot(fixed_error, roulette_error))
+          << fixed_mean << "vs" << roulette_mean;
+
+      // And the roulette paths are shorter
+      auto rays_per_sample = [&](const RussianRoulette &roulette) {
+        Renderer renderer;
+        RenderProgress progress;
+        renderer.settings.roulette = roulette;
+        scene.cam.samples_per_pixel = 4;
+        scene.cam.initialize();
+        Image image(scene.cam.image_width, scene.cam.image_height);
+        renderer.render_scene(scene, image, &progress);
+        auto totals = progress.snapshot();
+        return static_cast<double>(totals.rays) / totals.samples;
+      };
+      expect(rays_per_sample(RussianRoulette{}) < rays_per_sample(RussianRoulette{.enabled = false}));
+      Random::set_seed(0);
+    };
+
+    "mis_weight"_test = [] {
+      expect(mis_weight(MisHeuristic::Balance, 3, 1) == 0.75_d);
+      expect(mis_weight(MisHeuristic::Power, 3, 1) == 0.9_d);
+      expect(mis_weight(MisHeuristic::Power, 0, 1) == 0.0_d);
+      expect(mis_weight(MisHeuristic::Power, 1, 0) == 1.0_d);
+      expect(mis_weight(MisHeuristic::Power, glimpse::math::infinity, 2) == 1.0_d);
+      // The two strategies' weights add up to one
+      for (auto heuristic : {MisHeuristic::Balance, MisHeuristic::Power}) {
+        expect(std::abs(mis_weight(heuristic, 0.2, 5) + mis_weight(heuristic, 5, 0.2) - 1) < 1e-12);
+      }
+
+      MisHeuristic parsed = MisHeuristic::Power;
+      expect(parse_mis_heuristic("balance", parsed) && parsed == MisHeuristic::Balance);
+      expect(!parse_mis_heuristic("cubic", parsed) && parsed == MisHeuristic::Balance);
+      expect(std::string(to_string(MisHeuristic::Power)) == "power");
+    };
+
+    "next_event_estimation"_test = [] {
+      Random::set_seed(21);
+      // A quad light (cornell_box) and a sphere and a quad light (simple_light)
+      for (auto [name, u, v] : {std::tuple{"cornell_box", 0.5, 0.5}, std::tuple{"simple_light", 0.5, 0.35}}) {
+        Scene scene = Scene::SceneMap[name]();
+        scene.cam.image_width = 16;
+        scene.cam.initialize();
+        auto bvh = bvh_node(scene.world);
+        ray r = scene.cam.get_ray(u, v);
+
+        // Mean brightness of one pixel and its standard error
+        auto estimate = [&](const DirectLighting &direct) {
+          const int paths = 20000;
+          double sum = 0, sum_sq = 0;
+          for (int path = 0; path < paths; ++path) {
+            color c = ray_color(r, scene.background, bvh, scene.cam.max_depth, scene.lights, true, {}, direct);
+            double value = c.x() + c.y() + c.z();
+            sum += value;
+            sum_sq += value * value;
+          }
+          double mean = sum / paths;
+          return std::pair{mean, std::sqrt(std::max(0.0, sum_sq / paths - mean * mean) / paths)};
+        };
+
+        auto [mixture_mean, mixture_error] = estimate(DirectLighting{});
+        for (auto heuristic : {MisHeuristic::Balance, MisHeuristic::Power}) {
+          auto [nee_mean, nee_error] = estimate(DirectLighting{.next_event_estimation = true, .heuristic = heuristic});
+          // Same image, with much less noise
+          expect(std::abs(mixture_mean - nee_mean) < 5 * std::hypot(mixture_error, nee_error))
+              << name << mixture_mean << "vs" << nee_mean;
+          expect(nee_error < 0.7 * mixture_error) << name << nee_error << "vs" << mixture_error;
+        }
+      }
+
+      // Lights carrying their emitter only test visibility up to the light, shapes without a material take a
+      // closest hit. Same paths either way.
+      {
+        Scene scene = Scene::SceneMap["cornell_box"]();
+        scene.cam.image_width = 16;
+        scene.cam.initialize();
+        auto bvh = bvh_node(scene.world);
+        hittable_list shapes;
+        shapes.add(make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), nullptr));
+        const DirectLighting direct{.next_event_estimation = true};
+        bool same = true;
+        for (int path = 0; path < 1000; ++path) {
+          ray r = scene.cam.get_ray(0.5, 0.5);
+          Random::set_sample_stream(path, 0);
+          color emitters = ray_color(r, scene.background, bvh, scene.cam.max_depth, scene.lights, true, {}, direct);
+          Random::set_sample_stream(path, 0);
+          color placeholders = ray_color(r, scene.background, bvh, scene.cam.max_depth, shapes, true, {}, direct);
+          same = same && (emitters - placeholders).length() < 1e-9;
+        }
+        expect(same);
+      }
+
+      // Both engines
+      Scene scene = Scene::SceneMap["cornell_box"]();
+      scene.cam.image_width = 16;
+      scene.cam.samples_per_pixel = 64;
+      scene.cam.initialize();
+      auto bvh = bvh_node(scene.world);
+      Image image(scene.cam.image_width, scene.cam.image_height);
+      auto render = [&](RenderEngine engine) {
+        Renderer renderer;
+        renderer.settings.engine = engine;
+        renderer.settings.direct_lighting.next_event_estimation = true;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+        renderer.render(scene, bvh, image);
+        return frame_mean(renderer.film);
+      };
+      auto [megakernel_mean, megakernel_error] = render(RenderEngine::Megakernel);
+      auto [wavefront_mean, wavefront_error] = render(RenderEngine::Wavefront);
+      expect(std::abs(megakernel_mean - wavefront_mean) < 5 * std::hypot(megakernel_error, wavefront_error))
+          << megakernel_mean << "vs" << wavefront_mean;
+      Random::set_seed(0);
+    };
+
     "sample_square_stratified"_test = [] {
       // Test stratified sampling
       vec3 sample = sample_square_stratified(0, 0, 1.0);
@@ -116,13 +317,713 @@ void render_test() {
       expect(sample.z() == 0.0_d) << "Sample z should be 0";
     };
 
-    "stop_rendering"_test = [] {
-      // Test the stop rendering flag
-      Renderer::stop_rendering = true;
-      expect(Renderer::stop_rendering.load() == true);
+    "render_session"_test = [] {
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 1;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      RenderSession session;
+      session.set_scene(scene);
+
+      // Samples keep accumulating while nothing changes ...
+      session.render(image);
+      expect(session.film().get_sample_count(5, 2) == 1_i);
+      session.render(image);
+      expect(session.film().get_sample_count(5, 2) == 2_i);
+
+      // ... and a camera update restarts accumulation without a new scene.
+      auto cam = scene.cam;
+      cam.lookfrom = point3(0, 0, 0.5);
+      cam.initialize();
+      session.update_camera(cam);
+      session.render(image);
+      expect(session.film().get_sample_count(5, 2) == 1_i);
+      expect(session.scene().cam.lookfrom == point3(0, 0, 0.5));
+    };
+
+    "adaptive_sampling"_test = [] {
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 64;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.adaptive_sampling = true;
+      renderer.settings.min_spp = 4;
+      renderer.render_scene(scene, image);
+
+      // The corner only ever sees the constant background, so it stops at min_spp ...
+      expect(renderer.film.get_sample_count(0, 0) == 4_i);
+
+      // ... and nobody goes past the camera's samples per pixel.
+      for (int j = 0; j < scene.cam.image_height; ++j) {
+        for (int i = 0; i < scene.cam.image_width; ++i) {
+          expect(renderer.film.get_sample_count(i, j) <= 64_i);
+        }
+      }
+
+      // Degenerate sizes still sample and finish, rather than looping on pixels that never gain samples
+      renderer.settings.min_spp = 0;
+      renderer.settings.adaptive_batch = 0;
+      renderer.render_scene(scene, image);
+      expect(renderer.film.get_min_sample_count() >= 1_i);
+      expect(renderer.film.get_max_sample_count() <= 64_i);
+    };
+
+    "time_budget"_test = [] {
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 1;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.time_budget = 0.2;
+      renderer.render_scene(scene, image);
+
+      auto &stats = renderer.frame_stats;
+
+      // Keeps refining past the camera's samples per pixel, and stops close to the deadline.
+      expect(stats.max_spp > 1_i);
+      expect(stats.seconds >= 0.2_d);
+      expect(stats.seconds < 1.0_d);
+
+      // Evenly refined: nobody is more than one sample ahead.
+      expect(stats.pixels == scene.cam.image_width * scene.cam.image_height);
+      expect(stats.max_spp - stats.min_spp <= 1_i);
+      expect(stats.total_samples == renderer.film.get_total_sample_count());
+      expect(stats.min_spp <= stats.average_spp() && stats.average_spp() <= stats.max_spp);
+      expect(stats.passes >= stats.max_spp);
+    };
+
+    "summarize"_test = [] {
+      Film film(3, 1);
+      film.add_sample(0, 0, vec3(1, 1, 1));
+      film.add_sample(0, 0, vec3(1, 1, 1));
+
+      // Frame average: the second pixel has no samples yet
+      const Tile frame{0, 0, 3, 1};
+      expect(summarize(film, {frame}).relative_error == glimpse::math::infinity);
+      film.add_sample(1, 0, vec3(1, 1, 1));
+      film.add_sample(1, 0, vec3(3, 3, 3));
+
+      // Only the pixels under the tiles count
+      auto summary = summarize(film, {Tile{0, 0, 2, 1}});
+      expect(std::abs(summary.relative_error - film.get_relative_error(1, 0) / 2.0) < 1e-12);
+      expect(summary.total_samples == 4_ll);
+      expect(summary.min_spp == 2_i && summary.max_spp == 2_i);
+      expect(summarize(film, {frame}).min_spp == 0_i);
+    };
+
+    "error_target"_test = [] {
+      // Seeded: now and then an unseeded frame happens to be under the target after two samples
+      Random::set_seed(5);
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);  // lit, so the sphere is noisy
+      scene.cam.samples_per_pixel = 1;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.error_target = 0.005;
+      renderer.render_scene(scene, image);
+
+      auto &stats = renderer.frame_stats;
+      expect(stats.relative_error < 0.005_d);
+      auto summary = summarize(renderer.film, {Tile{0, 0, image.width, image.height}});
+      expect(stats.relative_error == summary.relative_error);
+      expect(stats.min_spp > 2_i);
+      expect(stats.max_spp == stats.min_spp);
+      expect(!stats.spp_capped);
+
+      // max_spp caps a target that is out of reach
+      renderer.settings.error_target = 1e-6;
+      renderer.settings.max_spp = 8;
+      renderer.render_scene(scene, image);
+      expect(renderer.frame_stats.max_spp == 8_i);
+      expect(renderer.frame_stats.relative_error > 1e-6);
+      expect(renderer.frame_stats.spp_capped);
+
+      // and without it, so does the default cap
+      renderer.settings.max_spp = 0;
+      renderer.settings.error_target_max_spp = 16;
+      renderer.render_scene(scene, image);
+      expect(renderer.frame_stats.max_spp == 16_i);
+      expect(renderer.frame_stats.spp_capped);
+      Random::set_seed(0);
+    };
+
+    "progressive"_test = [] {
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);
+      scene.cam.samples_per_pixel = 16;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.progressive = true;
+
+      std::vector<int> frames;
+      bool complete = true;
+      renderer.on_frame = [&](const Image &, const FrameStats &stats) {
+        frames.push_back(stats.max_spp);
+        complete = complete && stats.min_spp == stats.max_spp;
+      };
+      renderer.render_scene(scene, image);
+
+      // Doubling passes, every one of them a complete frame
+      expect(frames == std::vector<int>{1, 2, 4, 8, 16});
+      expect(complete);
+
+      auto resolved = image.get_float(5, 4);
+      auto expected = sqrt(renderer.film.get_sample(5, 4));
+      expect(std::abs(resolved.x() - expected.x()) <= 1.0 / 255);  // 8-bit image
+
+      // Uncapped keeps doubling up to samples_per_pixel per pass, until stopped
+      scene.cam.uncapped_spp = true;
+      frames.clear();
+      CancelToken cancel;
+      renderer.on_frame = [&](const Image &, const FrameStats &stats) {
+        frames.push_back(stats.max_spp);
+        if (frames.size() == 7) cancel.cancel();
+      };
+      renderer.render_scene(scene, image, nullptr, cancel);
+      expect(frames == std::vector<int>{1, 2, 4, 8, 16, 32, 48});
+    };
+
+    "resolve"_test = [] {
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);
+      scene.cam.samples_per_pixel = 16;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      auto matches_film = [&](const Renderer &renderer) {
+        for (int j = 0; j < image.height; ++j) {
+          for (int i = 0; i < image.width; ++i) {
+            auto expected = sqrt(renderer.film.get_sample(i, j));
+            auto resolved = image.get_float(i, j);
+            if (std::abs(resolved.y() - expected.y()) > 1.0 / 255) return false;  // 8-bit image
+          }
+        }
+        return true;
+      };
+
+      // Resolved once at the end, also with mid-pass resolves going on
+      for (double interval : {0.0, 1e-4}) {
+        Renderer renderer;
+        renderer.settings.resolve_interval = interval;
+        image.clear();
+        renderer.render_scene(scene, image);
+        expect(matches_film(renderer)) << interval;
+
+        image.clear();
+        renderer.resolve(image);
+        expect(matches_film(renderer)) << interval;
+      }
+    };
+
+    "pixel_order"_test = [] {
+      // 10x8 with 4px tiles: clipped edge tiles on both axes
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      for (auto order : {PixelOrder::Morton, PixelOrder::Hilbert}) {
+        Renderer renderer;
+        renderer.settings.tile_size = 4;
+        renderer.settings.pixel_order = order;
+        renderer.render_scene(scene, image);
+        expect(renderer.film.get_min_sample_count() == 4_i) << to_string(order);
+        expect(renderer.film.get_max_sample_count() == 4_i) << to_string(order);
+      }
+    };
+
+    "region_of_interest"_test = [] {
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);
+      scene.cam.image_width = 24;
+      scene.cam.aspect_ratio = 24.0 / 20.0;  // initialize() derives the height from it
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.max_depth = 4;
+      scene.cam.initialize();
+      bvh_node world(scene.world);
+
+      Random::set_seed(42);
+
+      Image full_image(scene.cam.image_width, scene.cam.image_height);
+      Renderer full;
+      full.film.initialize(scene.cam.image_width, scene.cam.image_height);
+      full.render(scene, world, full_image);
+
+      // Different tile size and pixel order, so the samples run on other threads in another order
+      Image roi_image(scene.cam.image_width, scene.cam.image_height);
+      Renderer roi;
+      roi.settings.tile_size = 8;
+      roi.settings.pixel_order = PixelOrder::Hilbert;
+      roi.settings.regions = {{3, 4, 11, 9}, {9, 7, 17, 15}};
+      roi.film.initialize(scene.cam.image_width, scene.cam.image_height);
+      roi.render(scene, world, roi_image);
+
+      Random::set_seed(0);
+
+      auto inside = [](int x, int y) {
+        return (x >= 3 && x < 11 && y >= 4 && y < 9) || (x >= 9 && x < 17 && y >= 7 && y < 15);
+      };
+
+      bool identical = true, untouched = true;
+      for (int y = 0; y < scene.cam.image_height; ++y) {
+        for (int x = 0; x < scene.cam.image_width; ++x) {
+          auto a = full.film.get_accumulated_sample(x, y);
+          auto b = roi.film.get_accumulated_sample(x, y);
+          if (inside(x, y)) {
+            identical = identical && a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+            identical = identical && full_image.get(x, y).rgb[0] == roi_image.get(x, y).rgb[0];
+          } else {
+            untouched = untouched && roi.film.get_sample_count(x, y) == 0;
+          }
+        }
+      }
+      expect(identical) << "region differs from the full frame";
+      expect(untouched) << "pixels outside the regions were rendered";
+
+      // Overlap rendered once, stats only cover the regions
+      expect(roi.frame_stats.pixels == 40 + 64 - 4);
+      expect(roi.frame_stats.min_spp == 4_i);
+    };
+
+    "importance_map"_test = [] {
+      // 10x8 frame, everything on the left half
+      Scene scene = create_test_scene();
+      scene.cam.aspect_ratio = 10.0 / 8.0;
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.initialize();
+      const int width = scene.cam.image_width, height = scene.cam.image_height;
+
+      std::vector<float> importance(width * height, 0.0f);
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width / 2; ++x) importance[y * width + x] = 1.0f;
+      }
+
+      // 320 samples: one each, the other 240 over the 40 left pixels
+      auto spp = allocate_samples(importance, {{0, 0, width, height}}, width, 320);
+      expect(spp[0] == 7_i);
+      expect(spp[width - 1] == 1_i);
+      expect(std::accumulate(spp.begin(), spp.end(), 0) == 320_i);
+
+      // Uneven weights still add up exactly
+      std::vector<float> ramp(width * height);
+      for (size_t k = 0; k < ramp.size(); ++k) ramp[k] = static_cast<float>(k % 7);
+      auto uneven = allocate_samples(ramp, {{0, 0, width, height}}, width, 1001);
+      expect(std::accumulate(uneven.begin(), uneven.end(), 0) == 1001_i);
+      expect(*std::min_element(uneven.begin(), uneven.end()) >= 1_i);
+
+      // A budget no int holds, all of it on one pixel, stops at the cap
+      std::vector<float> peak(width * height, 0.0f);
+      peak[0] = 1.0f;
+      auto capped = allocate_samples(peak, {{0, 0, width, height}}, width, 1LL << 40, 1000);
+      expect(capped[0] == 1000_i);
+      expect(capped[1] == 1_i);
+      auto uncapped = allocate_samples(peak, {{0, 0, width, height}}, width, 1LL << 40);
+      expect(uncapped[0] == std::numeric_limits<int>::max());
+
+      Image image(width, height);
+      Renderer renderer;
+      renderer.settings.importance = importance;
+      renderer.render_scene(scene, image);
+      expect(renderer.film.get_sample_count(0, 0) == 7_i);
+      expect(renderer.film.get_sample_count(width - 1, height - 1) == 1_i);
+      expect(renderer.frame_stats.total_samples == 320_ll);
+
+      // A painted weight image works the same
+      Image painted(width, height);
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width / 2; ++x) painted.set_float(x, y, 1.0f, 1.0f, 1.0f);
+      }
+      expect(importance_from_image(painted) == importance);
+    };
+
+    "thread_count"_test = [] {
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.num_threads = 3;
+      renderer.render_scene(scene, image);
+      expect(renderer.worker_stats.size() == 3_u);
+      expect(renderer.film.get_min_sample_count() == 4_i);
+
+      // Changing the settings restarts the pool, pinned or not the frame comes out the same
+      renderer.settings.num_threads = 2;
+      renderer.settings.pin_threads = true;
+      renderer.render_scene(scene, image);
+      expect(renderer.worker_stats.size() == 2_u);
+      expect(renderer.film.get_min_sample_count() == 4_i);
+    };
+
+    "wavefront"_test = [] {
+      Random::set_seed(7);
+      Scene scene = Scene::SceneMap["cornell_box"]();
+      scene.cam.image_width = 16;
+      scene.cam.samples_per_pixel = 64;
+      scene.cam.initialize();
+      auto bvh = bvh_node(scene.world);
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      auto render = [&](RenderEngine engine, int threads, int wave_size) {
+        Renderer renderer;
+        renderer.settings.engine = engine;
+        renderer.settings.num_threads = threads;
+        renderer.settings.wave_size = wave_size;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+        renderer.render(scene, bvh, image);
+        return renderer;
+      };
+
+      auto megakernel = render(RenderEngine::Megakernel, 2, 4096);
+      auto wavefront = render(RenderEngine::Wavefront, 2, 1000);  // waves cut through tiles and samples
+      expect(wavefront.film.get_min_sample_count() == 64_i);
+      expect(wavefront.film.get_max_sample_count() == 64_i);
+
+      // Same estimator: the frames agree within their noise
+      auto [megakernel_mean, megakernel_error] = frame_mean(megakernel.film);
+      auto [wavefront_mean, wavefront_error] = frame_mean(wavefront.film);
+      expect(std::abs(megakernel_mean - wavefront_mean) < 5 * std::hypot(megakernel_error, wavefront_error))
+          << megakernel_mean << "vs" << wavefront_mean;
+
+      // Seeded paths draw the same numbers on any thread and in waves of any size
+      for (auto [threads, wave_size] : {std::pair{1, 1000}, std::pair{2, 96}}) {
+        auto other = render(RenderEngine::Wavefront, threads, wave_size);
+        bool identical = true;
+        for (int j = 0; j < image.height; ++j) {
+          for (int i = 0; i < image.width; ++i) {
+            identical = identical && other.film.get_mean(i, j) == wavefront.film.get_mean(i, j);
+          }
+        }
+        expect(identical) << "threads:" << threads << "wave size:" << wave_size;
+      }
+
+      // Adaptive passes go through the same sample lists
+      Renderer adaptive;
+      adaptive.settings.engine = RenderEngine::Wavefront;
+      adaptive.settings.adaptive_sampling = true;
+      adaptive.settings.min_spp = 8;
+      adaptive.film.initialize(scene.cam.image_width, scene.cam.image_height);
+      adaptive.render(scene, bvh, image);
+      expect(adaptive.film.get_min_sample_count() >= 8_i);
+      expect(adaptive.film.get_max_sample_count() <= 64_i);
+      Random::set_seed(0);
+    };
+
+    "wavefront_sorting"_test = [] {
+      Random::set_seed(11);
+      Scene scene = Scene::SceneMap["material_showcase"]();
+      scene.cam.image_width = 16;
+      scene.cam.samples_per_pixel = 16;
+      scene.cam.initialize();
+      auto bvh = bvh_node(scene.world);
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      auto render = [&](bool sort_by_material, bool sort_rays, int threads) {
+        Renderer renderer;
+        renderer.settings.engine = RenderEngine::Wavefront;
+        renderer.settings.sort_by_material = sort_by_material;
+        renderer.settings.sort_rays = sort_rays;
+        renderer.settings.num_threads = threads;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+        renderer.render(scene, bvh, image);
+        return renderer;
+      };
+
+      // Only the shading or intersection order changes, and every path keeps its own random stream: a seeded
+      // render comes out the same sample for sample
+      auto unsorted = render(false, false, 2);
+      for (auto [sort_by_material, sort_rays] : {std::pair{true, false}, std::pair{false, true}}) {
+        for (int threads : {1, 2}) {
+          auto sorted = render(sort_by_material, sort_rays, threads);
+          expect(sorted.film.get_min_sample_count() == 16_i);
+          bool identical = true;
+          for (int j = 0; j < image.height; ++j) {
+            for (int i = 0; i < image.width; ++i) {
+              identical = identical && unsorted.film.get_mean(i, j) == sorted.film.get_mean(i, j);
+            }
+          }
+          expect(identical) << "with rays sorted:" << sort_rays << "threads:" << threads;
+        }
+      }
+      Random::set_seed(0);
+    };
+
+    "wavefront_packets"_test = [] {
+      // Packets find the same camera ray hits, so a seeded render comes out the same sample for sample. Volumes
+      // draw from each path's own stream either way.
+      for (const char *name : {"cornell_box", "cornell_smoke"}) {
+        Random::set_seed(12);
+        Scene scene = Scene::SceneMap[name]();
+        scene.cam.image_width = 16;
+        scene.cam.samples_per_pixel = 16;
+        scene.cam.initialize();
+        auto bvh = bvh_node(scene.world);
+        Image image(scene.cam.image_width, scene.cam.image_height);
+
+        auto render = [&](bool packets) {
+          Renderer renderer;
+          renderer.settings.engine = RenderEngine::Wavefront;
+          renderer.settings.packet_camera_rays = packets;
+          renderer.settings.num_threads = 1;
+          renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+          renderer.render(scene, bvh, image);
+          return renderer;
+        };
+
+        auto single = render(false);
+        auto packets = render(true);
+        expect(packets.film.get_min_sample_count() == 16_i);
+        bool identical = true;
+        for (int j = 0; j < image.height; ++j) {
+          for (int i = 0; i < image.width; ++i) {
+            identical = identical && single.film.get_mean(i, j) == packets.film.get_mean(i, j);
+          }
+        }
+        expect(identical) << name;
+      }
+      Random::set_seed(0);
+    };
+
+    "sampling_modes"_test = [] {
+      auto modes = [](const RenderSettings &settings, bool uncapped = false) {
+        std::string names;
+        for (auto mode : sampling_modes(settings, uncapped)) names += std::string(names.empty() ? "" : " ") + mode;
+        return names;
+      };
+      RenderSettings settings;
+      expect(modes(settings) == std::string(""));
+      expect(modes(settings, true) == std::string("uncapped"));
+
+      settings.adaptive_sampling = true;
+      expect(modes(settings, true) == std::string("uncapped adaptive"));
+      settings.importance = {1.0f};
+      expect(modes(settings) == std::string("importance adaptive"));
+
+      // A time budget is an error target's deadline, an uncapped camera just runs progressive passes forever
+      settings = RenderSettings{};
+      settings.progressive = true;
+      expect(modes(settings, true) == std::string("progressive"));
+      settings.time_budget = 1;
+      expect(modes(settings) == std::string("time-budget progressive"));
+      settings.progressive = false;
+      settings.error_target = 0.1;
+      expect(modes(settings) == std::string("error-target"));
+    };
+
+    "scene_features"_test = [] {
+      auto features = [](const char *name) { return to_string(SceneFeatures::of(Scene::SceneMap[name]())); };
+      expect(features("random_scene") == std::string("motion+defocus"));
+      expect(features("quads") == std::string("none"));
+      expect(features("cornell_box") == std::string("lights+defocus"));
+      expect(features("cornell_smoke") == std::string("lights+defocus+volumes"));
+      expect(features("final_scene") == std::string("motion+defocus+volumes"));  // builds a light list, never sets it
+      expect(to_string(SceneFeatures{}) == std::string("lights+motion+defocus+volumes"));
+
+      // Wrapped and nested geometry is looked through
+      auto mat = make_shared<lambertian>(color(0.5, 0.5, 0.5));
+      auto still = make_shared<sphere>(point3(0, 0, 0), 1, mat);
+      auto moving = make_shared<sphere>(point3(0, 0, 0), point3(0, 1, 0), 1, mat);
+      expect(!still->is_moving());
+      expect(moving->is_moving());
+      expect(make_shared<translate>(moving, vec3(1, 0, 0))->is_moving());
+      hittable_list list(still);
+      expect(!bvh_node(list).is_moving());
+      list.add(make_shared<rotate_y>(moving, 30));
+      expect(bvh_node(list).is_moving());
+      expect(!list.has_volume());
+    };
+
+    "specialized_variants"_test = [] {
+      auto render = [](Scene &scene, const hittable &bvh, RenderEngine engine, bool specialize) {
+        Random::set_seed(13);
+        Image image(scene.cam.image_width, scene.cam.image_height);
+        Renderer renderer;
+        renderer.settings.engine = engine;
+        renderer.settings.specialize = specialize;
+        renderer.settings.num_threads = 1;
+        renderer.film.initialize(scene.cam.image_width, scene.cam.image_height);
+        renderer.render(scene, bvh, image);
+        Random::set_seed(0);
+        return renderer;
+      };
+
+      // With motion and defocus the specialized variant draws the same numbers as the generic one: same image
+      Scene moving = Scene::SceneMap["random_scene"]();
+      moving.cam.image_width = 16;
+      moving.cam.samples_per_pixel = 4;
+      moving.cam.initialize();
+      auto moving_bvh = bvh_node(moving.world);
+      for (auto engine : {RenderEngine::Megakernel, RenderEngine::Wavefront}) {
+        auto generic = render(moving, moving_bvh, engine, false);
+        auto specialized = render(moving, moving_bvh, engine, true);
+        bool identical = true;
+        for (int j = 0; j < moving.cam.image_height; ++j) {
+          for (int i = 0; i < moving.cam.image_width; ++i) {
+            identical = identical && generic.film.get_mean(i, j) == specialized.film.get_mean(i, j);
+          }
+        }
+        expect(identical) << to_string(engine);
+      }
+
+      // Without them it skips the random time and lens sample, so the two only agree statistically
+      Scene still = Scene::SceneMap["cornell_box"]();
+      still.cam.defocus_angle = 0;
+      still.cam.image_width = 16;
+      still.cam.samples_per_pixel = 64;
+      still.cam.initialize();
+      auto still_bvh = bvh_node(still.world);
+      for (auto engine : {RenderEngine::Megakernel, RenderEngine::Wavefront}) {
+        auto [generic_mean, generic_error] = frame_mean(render(still, still_bvh, engine, false).film);
+        auto [specialized_mean, specialized_error] = frame_mean(render(still, still_bvh, engine, true).film);
+        expect(std::abs(generic_mean - specialized_mean) < 5 * std::hypot(generic_error, specialized_error))
+            << to_string(engine) << generic_mean << "vs" << specialized_mean;
+      }
+    };
+
+    "scaling"_test = [] {
+      expect(scaling_thread_counts(1) == std::vector<int>{1});
+      expect(scaling_thread_counts(6) == std::vector<int>{1, 2, 4, 6});
+      expect(scaling_thread_counts(8) == std::vector<int>{1, 2, 4, 8});
+
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 4;
+      auto report = run_scaling(scene, 2);
+
+      expect(report.strong.size() == 2_u);
+      expect(report.strong[0].speedup == 1.0_d);
+      expect(report.strong[0].efficiency == 1.0_d);
+      expect(report.strong[1].samples == report.strong[0].samples);
+
+      // Weak scaling doubles the work with the threads
+      expect(report.weak.size() == 2_u);
+      expect(report.weak[1].threads == 2_i);
+      expect(report.weak[1].samples > report.weak[0].samples);
+
+      // Whatever sampling mode the settings ask for, the work is the whole frame at the camera's spp
+      RenderSettings settings;
+      settings.progressive = true;
+      settings.regions = {Tile{0, 0, 2, 2}};
+      settings.importance = {1.0f};
+      auto fixed = run_scaling(scene, 1, settings);
+      expect(fixed.strong[0].samples == report.strong[0].samples);
+    };
+
+    "progress_counters"_test = [] {
+      RenderProgress progress;
+      progress.start(3);
+      progress.worker(0).add_sample(2);
+      progress.worker(2).add_sample(5);
+      progress.worker(2).add_work_unit();
+      auto totals = progress.snapshot();
+      expect(totals.samples == 2_ull);
+      expect(totals.rays == 7_ull);
+      expect(totals.work_units == 1_ull);
+
+      // Restarting zeroes every worker
+      progress.start(2);
+      expect(progress.snapshot().samples == 0_ull);
+
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.max_depth = 3;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      renderer.settings.tile_size = 4;
+      renderer.settings.num_threads = 2;
+      renderer.render_scene(scene, image, &progress);
+
+      totals = progress.snapshot();
+      expect(totals.samples == static_cast<uint64_t>(renderer.film.get_total_sample_count()));
+      expect(totals.work_units == 6_ull);  // 10x5 in 4px tiles, one pass
+      // Every sample traces its camera ray, bounces add more, the last one at depth 0
+      expect(totals.rays >= totals.samples);
+      expect(totals.rays <= totals.samples * 4);
+      expect(totals.rays > totals.samples) << "the sphere scatters some camera rays";
+    };
+
+    "cancel_token"_test = [] {
+      CancelToken token;
+      CancelToken copy = token;
+      expect(!copy.is_cancelled());
+
+      token.cancel();
+      expect(copy.is_cancelled());
+      expect(copy.cancel_time() <= std::chrono::steady_clock::now());
+
+      // A fresh token for the next render
+      expect(!CancelToken{}.is_cancelled());
+
+      // Cancelled before it starts: nothing is rendered
+      Scene scene = create_test_scene();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+      Renderer renderer;
+      renderer.render_scene(scene, image, nullptr, token);
+      expect(renderer.film.get_total_sample_count() == 0_ll);
+    };
+
+    "stop_latency"_test = [] {
+      Scene scene = create_test_scene();
+      scene.background = color(0.7, 0.8, 1.0);
+      scene.cam.image_width = 64;
+      scene.cam.image_height = 64;
+      scene.cam.samples_per_pixel = 10000;
+      scene.cam.uncapped_spp = true;
+      scene.cam.initialize();
+      Image image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer renderer;
+      CancelToken cancel;
+      auto future = std::async(std::launch::async, [&]() { renderer.render_scene(scene, image, nullptr, cancel); });
+
+      // In the middle of a 40M sample pass
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      cancel.cancel();
+      future.wait();
+
+      // Workers check before every sample, a sample here costs microseconds
+      expect(renderer.frame_stats.stop_latency > 0.0_d);
+      expect(renderer.frame_stats.stop_latency < 0.05_d);
+    };
+
+    "independent_renderers"_test = [] {
+      Scene scene = create_test_scene();
+      scene.cam.samples_per_pixel = 4;
+      scene.cam.initialize();
+
+      Scene preview = scene;
+      preview.cam.uncapped_spp = true;
+
+      Image preview_image(scene.cam.image_width, scene.cam.image_height);
+      Image final_image(scene.cam.image_width, scene.cam.image_height);
+
+      Renderer preview_renderer;
+      CancelToken preview_cancel;
+      auto future = std::async(std::launch::async, [&]() {
+        preview_renderer.render_scene(preview, preview_image, nullptr, preview_cancel);
+      });
+
+      // Runs to completion while the uncapped preview keeps going
+      Renderer final_renderer;
+      final_renderer.render_scene(scene, final_image);
+      expect(final_renderer.film.get_min_sample_count() == 4_i);
+      expect(final_renderer.frame_stats.stop_latency == 0.0_d);
+      expect(future.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
 
-      Renderer::stop_rendering = false;
-      expect(Renderer::stop_rendering.load() == false);
+      preview_cancel.cancel();
+      future.wait();
+      expect(preview_renderer.frame_stats.stop_latency > 0.0_d);
     };
   };
 }
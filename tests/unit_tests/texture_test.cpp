@@ -15,9 +15,9 @@ void texture_test() {
     point3 point(1.0, 2.0, 3.0);
     color result = texture.value(0.5, 0.5, point);
 
-    expect(that % result.x() == 0.8);
-    expect(that % result.y() == 0.3);
-    expect(that % result.z() == 0.2);
+    expect(that % result.x() == real(0.8));
+    expect(that % result.y() == real(0.3));
+    expect(that % result.z() == real(0.2));
   };
 
   "checker_texture"_test = [] {
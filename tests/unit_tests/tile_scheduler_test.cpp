@@ -0,0 +1,119 @@
+#include "core/tile_scheduler.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+//
+#include "../test_cfg.h"
+
+using namespace glimpse;
+
+void tile_scheduler_test() {
+  using namespace boost::ut;
+
+  "tile_scheduler"_test = [] {
+    "covers_frame"_test = [] {
+      // 50x30 with 16px tiles -> 4x2 tiles, edge tiles clipped to the frame
+      TileScheduler scheduler(50, 30, 16, 3);
+      expect(scheduler.tiles().size() == 8_u);
+
+      int pixels = 0;
+      for (auto &tile : scheduler.tiles()) {
+        expect(tile.x1 <= 50_i);
+        expect(tile.y1 <= 30_i);
+        pixels += tile.pixel_count();
+      }
+      expect(pixels == 1500_i);
+    };
+
+    "each_tile_once"_test = [] {
+      TileScheduler scheduler(64, 64, 8, 4);
+
+      std::set<std::pair<int, int>> seen;
+      Tile tile;
+      bool stolen = false;
+      for (int w = 0; w < 4; ++w) {
+        while (scheduler.next(w, tile, stolen)) {
+          expect(seen.insert({tile.x0, tile.y0}).second) << "tile handed out twice";
+        }
+      }
+      expect(seen.size() == scheduler.tiles().size());
+    };
+
+    "steals_when_idle"_test = [] {
+      TileScheduler scheduler(64, 64, 8, 4);
+
+      // A single worker drains its own queue first, then steals everything else.
+      Tile tile;
+      bool stolen = false;
+      int own = 0, taken = 0;
+      while (scheduler.next(0, tile, stolen)) {
+        stolen ? taken++ : own++;
+      }
+      expect(own == 16_i);
+      expect(taken == 48_i);
+
+      // reset() hands out the full frame again
+      scheduler.reset();
+      expect(scheduler.next(1, tile, stolen));
+      expect(!stolen);
+    };
+
+    "finished_tiles"_test = [] {
+      TileScheduler scheduler(32, 32, 16, 2);
+
+      // Each finished tile is handed out once, until reset() starts a new pass
+      Tile first, second;
+      bool stolen = false;
+      scheduler.next(0, first, stolen);
+      scheduler.next(1, second, stolen);
+      scheduler.finish(first);
+      auto finished = scheduler.take_finished();
+      expect(finished.size() == 1_ul && finished[0] == first);
+      scheduler.finish(second);
+      finished = scheduler.take_finished();
+      expect(finished.size() == 1_ul && finished[0] == second);
+      expect(scheduler.take_finished().empty());
+
+      scheduler.finish(first);
+      scheduler.reset();
+      expect(scheduler.take_finished().empty());
+    };
+
+    "regions"_test = [] {
+      // Two overlapping rectangles and one hanging off the frame edge
+      std::vector<Tile> regions = {{5, 5, 20, 12}, {10, 8, 30, 18}, {45, 25, 60, 40}};
+      TileScheduler scheduler(50, 30, 16, 2, regions);
+
+      std::set<std::pair<int, int>> covered;
+      for (auto &tile : scheduler.tiles()) {
+        // Stays inside one grid cell
+        expect(tile.x0 / 16 == (tile.x1 - 1) / 16 && tile.y0 / 16 == (tile.y1 - 1) / 16);
+        for (int y = tile.y0; y < tile.y1; ++y) {
+          for (int x = tile.x0; x < tile.x1; ++x) {
+            expect(covered.insert({x, y}).second) << "pixel in two tiles";
+          }
+        }
+      }
+
+      std::set<std::pair<int, int>> expected;
+      for (auto &region : regions) {
+        for (int y = region.y0; y < std::min(region.y1, 30); ++y) {
+          for (int x = region.x0; x < std::min(region.x1, 50); ++x) {
+            expected.insert({x, y});
+          }
+        }
+      }
+      // Compared outside expect(), whose operator== would try to print the pixel sets
+      bool same_pixels = covered == expected;
+      expect(same_pixels);
+
+      // Rows with the same coverage are merged: the first region alone in the top-left cell is one tile
+      TileScheduler single(50, 30, 16, 1, {{2, 3, 9, 11}});
+      expect(single.tiles().size() == 1_u);
+      expect(single.tiles()[0].pixel_count() == 56_i);
+    };
+  };
+}
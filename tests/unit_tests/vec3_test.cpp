@@ -1,5 +1,7 @@
 #include "core/vec3.h"
 
+#include <cmath>
+
 #include "../test_cfg.h"
 
 using namespace glimpse;
@@ -105,5 +107,33 @@ void vec3_test() {
       expect(mult.y() == 12.0_d);
       expect(mult.z() == 20.0_d);
     };
+
+    // The SIMD backend (USE_SIMD_VEC3) has to round exactly like the component formulas, in the same order
+    "backend_rounding"_test = [] {
+      Random::set_seed(24);
+      bool same = true;
+      for (int i = 0; i < 1000; ++i) {
+        vec3 u = vec3::random(-10, 10), v = vec3::random(-10, 10);
+        real t = static_cast<real>(random_double(-10, 10));
+
+        same &= dot(u, v) == u.x() * v.x() + u.y() * v.y() + u.z() * v.z();
+        same &= u.length_squared() == u.x() * u.x() + u.y() * u.y() + u.z() * u.z();
+        same &= cross(u, v) == vec3(u.y() * v.z() - u.z() * v.y(), u.z() * v.x() - u.x() * v.z(),
+                                    u.x() * v.y() - u.y() * v.x());
+        same &= u + v == vec3(u.x() + v.x(), u.y() + v.y(), u.z() + v.z());
+        same &= u - v == vec3(u.x() - v.x(), u.y() - v.y(), u.z() - v.z());
+        same &= t * u == vec3(t * u.x(), t * u.y(), t * u.z());
+        same &= u / t == vec3((1 / t) * u.x(), (1 / t) * u.y(), (1 / t) * u.z());
+
+        real inverse_length = 1 / std::sqrt(u.x() * u.x() + u.y() * u.y() + u.z() * u.z());
+        same &= unit_vector(u) == vec3(inverse_length * u.x(), inverse_length * u.y(), inverse_length * u.z());
+      }
+      expect(same);
+      Random::set_seed(0);
+
+      // Negation flips the sign of zero too
+      vec3 negated = -vec3(0, 1, 0);
+      expect(std::signbit(negated.x()) && std::signbit(negated.z()));
+    };
   };
 };
\ No newline at end of file